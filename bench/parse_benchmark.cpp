@@ -0,0 +1,123 @@
+// 数据文件解析吞吐对比：旧的 stringstream + std::stoi/std::stod 方式
+// 与 TextParser 的 string_view + std::from_chars 方式。
+// 构建：cmake -DBUILD_BENCHMARKS=ON，运行 bin/parse_benchmark [行数]
+#include "../include/TextParser.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+
+namespace {
+
+std::vector<std::string> legacySplit(const std::string& str, char delimiter) {
+    std::vector<std::string> tokens;
+    std::stringstream ss(str);
+    std::string token;
+    while (std::getline(ss, token, delimiter)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// 生成与 meals.txt 相同格式的数据
+std::string makeMealData(size_t lines) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> foodDist(1, 50);
+    std::uniform_real_distribution<> nutrientDist(0.0, 800.0);
+    const char* types[] = {"breakfast", "lunch", "dinner"};
+    std::stringstream ss;
+    for (size_t i = 0; i < lines; ++i) {
+        ss << (i + 1) << "|" << (i % 500 + 1) << "|2026-" << (i % 12 + 1 < 10 ? "0" : "")
+           << (i % 12 + 1) << "-1" << (i % 9) << "|" << types[i % 3] << "|"
+           << nutrientDist(gen) << "|" << nutrientDist(gen) / 10 << "|"
+           << nutrientDist(gen) / 5 << "|" << nutrientDist(gen) / 20 << "|1|";
+        int foods = 3 + static_cast<int>(i % 2);
+        for (int f = 0; f < foods; ++f) {
+            if (f) ss << ",";
+            ss << foodDist(gen);
+        }
+        ss << "\n";
+    }
+    return ss.str();
+}
+
+double legacyParse(const std::string& data) {
+    std::stringstream file(data);
+    std::string line;
+    double checksum = 0;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        auto tokens = legacySplit(line, '|');
+        if (tokens.size() < 10) continue;
+        checksum += std::stoi(tokens[0]) + std::stoi(tokens[1]);
+        checksum += tokens[2].size() + tokens[3].size();
+        for (int i = 4; i < 8; ++i) checksum += std::stod(tokens[i]);
+        for (const auto& id : legacySplit(tokens[9], ',')) {
+            if (!id.empty()) checksum += std::stoi(id);
+        }
+    }
+    return checksum;
+}
+
+double textParserParse(const std::string& data) {
+    TextParser::LineReader reader(data);
+    std::vector<std::string_view> tokens;
+    std::string_view line;
+    double checksum = 0;
+    while (reader.next(line)) {
+        if (line.empty()) continue;
+        if (TextParser::split(line, '|', tokens) < 10) continue;
+        checksum += TextParser::toInt(tokens[0]) + TextParser::toInt(tokens[1]);
+        checksum += tokens[2].size() + tokens[3].size();
+        for (int i = 4; i < 8; ++i) checksum += TextParser::toDouble(tokens[i]);
+        std::string_view ids = tokens[9];
+        size_t start = 0;
+        while (start < ids.size()) {
+            size_t end = ids.find(',', start);
+            if (end == std::string_view::npos) end = ids.size();
+            if (end > start) checksum += TextParser::toInt(ids.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+    return checksum;
+}
+
+template <typename Fn>
+double measureMBps(const std::string& data, Fn parse, double& checksum) {
+    const int rounds = 5;
+    double best = 0;
+    for (int r = 0; r < rounds; ++r) {
+        auto begin = std::chrono::steady_clock::now();
+        checksum = parse(data);
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - begin).count();
+        double mbps = data.size() / (1024.0 * 1024.0) / seconds;
+        if (mbps > best) best = mbps;
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t lines = argc > 1 ? std::stoul(argv[1]) : 500000;
+    std::string data = makeMealData(lines);
+
+    double legacySum = 0, parserSum = 0;
+    double legacy = measureMBps(data, legacyParse, legacySum);
+    double parser = measureMBps(data, textParserParse, parserSum);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "meal lines:  " << lines << " (" << data.size() / (1024.0 * 1024.0) << " MB)" << std::endl;
+    std::cout << "stringstream + stoi/stod: " << legacy << " MB/s" << std::endl;
+    std::cout << "TextParser (from_chars):  " << parser << " MB/s" << std::endl;
+    std::cout << "speedup: " << std::setprecision(2) << parser / legacy << "x" << std::endl;
+    if (legacySum != parserSum) {
+        std::cout << "checksum mismatch: " << legacySum << " vs " << parserSum << std::endl;
+        return 1;
+    }
+    return 0;
+}
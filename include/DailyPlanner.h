@@ -0,0 +1,65 @@
+#ifndef DAILY_PLANNER_H
+#define DAILY_PLANNER_H
+
+#include "FoodCatalog.h"
+#include "ScoringKernel.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// 每日推荐的生成方式
+enum class PlanMode {
+    Greedy,             // 按比例拆分目标后逐餐、逐类别挑选
+    Balanced,           // 全天联合优化营养偏差，每种食物一份
+    BalancedPortions    // 同上，并允许 0.5 到 2 份
+};
+
+// 全天联合配餐：每个槽位对应某一餐模板中的一个类别，为每个槽位选一种食物和份数，
+// 使全天热量、蛋白质、碳水和脂肪总和与目标的相对偏差之和（加上各食物的附加代价）最小。
+//
+// 分支定界：槽位按营养取值范围从大到小排列，逐个槽位展开。下界把剩余槽位的
+// 每种营养素各自放宽到 [最小可能和, 最大可能和] 区间，再加上剩余槽位的最小附加代价；
+// 下界不优于当前最好解的分支直接剪掉。子节点按"剩余槽位取平均值时的偏差"排序，
+// 第一条路径就能得到较好的解。超出时间预算时返回已找到的最好解。
+class DailyPlanner {
+public:
+    struct Candidate {
+        size_t row;         // 目录行号
+        double cost;        // 附加代价，如多样性扣分，与相对偏差同一量纲
+    };
+
+    struct Slot {
+        size_t meal;        // 所属餐的下标，只用于调用方还原结果
+        std::vector<Candidate> candidates;
+    };
+
+    struct Options {
+        std::vector<double> portions = {1.0};
+        double timeBudgetMs = 50.0;
+        // 同一天内同一种食物最多选一次
+        bool distinctFoods = true;
+        // 已有方案（如逐餐挑选的结果）的目标值：只搜索严格更好的方案，用于一开始就收紧剪枝
+        double incumbent = std::numeric_limits<double>::infinity();
+    };
+
+    struct Choice {
+        size_t row;
+        double portion;
+    };
+
+    struct Result {
+        std::vector<Choice> choices;    // 与 slots 一一对应；没有比 incumbent 更好的可行解时为空
+        double objective;               // 相对偏差之和加附加代价
+        bool complete;                  // 搜索在预算内完成，结果为最优解
+        uint64_t nodes;                 // 展开的节点数
+    };
+
+    // 营养总和与目标的相对偏差之和，即 solve 的目标值中不含附加代价的部分
+    static double deviation(const ScoringKernel::Targets& totals, const ScoringKernel::Targets& goals);
+
+    // 候选为空的槽位被跳过，其 Choice 的 portion 为 0
+    static Result solve(const FoodCatalog& catalog, const std::vector<Slot>& slots,
+                        const ScoringKernel::Targets& goals, const Options& options);
+};
+
+#endif
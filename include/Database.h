@@ -4,28 +4,194 @@
 #include "User.h"
 #include "Food.h"
 #include "Meal.h"
+#include "FoodCatalog.h"
+#include "MealLog.h"
+#include "SnapshotFile.h"
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <set>
+#include <utility>
+#include <shared_mutex>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// 一组原子提交的餐单变更：内存中一次性应用，日志中作为一个批次一次写入
+class MealBatch {
+public:
+    enum class OpType { Insert, Delete, DeleteDay };
+
+    struct Op {
+        OpType type;
+        Meal meal;          // Insert：id 小于等于 0 时在提交时分配新ID
+        int mealId;         // Delete
+        Date date;          // DeleteDay
+        int userId;         // DeleteDay
+    };
+
+    void insert(const Meal& meal) { ops.push_back({OpType::Insert, meal, 0, Date(), 0}); }
+    void remove(int mealId) { ops.push_back({OpType::Delete, Meal(), mealId, Date(), 0}); }
+    void removeDay(const Date& date, int userId) { ops.push_back({OpType::DeleteDay, Meal(), 0, date, userId}); }
+
+    bool empty() const { return ops.empty(); }
+    const std::vector<Op>& getOps() const { return ops; }
+
+private:
+    std::vector<Op> ops;
+};
+
+// 分页位置：上一页最后一条餐单的日期和ID
+struct MealCursor {
+    Date date;
+    int mealId;
+};
+
+struct MealPage {
+    std::vector<Meal> meals;
+    bool hasMore;
+    MealCursor next;    // hasMore 为 true 时有效，传给下一次查询
+};
+
+// 持久化策略：Sync 在请求线程上同步落盘；Interval 和 Mutations 由后台线程
+// 按时间间隔或累计变更数统一落盘，请求只修改内存，关闭时写出所有未落盘的变更
+struct PersistPolicy {
+    enum class Mode { Sync, Interval, Mutations };
+
+    Mode mode;
+    int intervalMs;
+    size_t mutationThreshold;
+
+    static PersistPolicy sync() { return {Mode::Sync, 0, 0}; }
+    static PersistPolicy interval(int ms) { return {Mode::Interval, ms, 0}; }
+    static PersistPolicy everyMutations(size_t count) { return {Mode::Mutations, 0, count}; }
+
+    // "sync"、"interval:毫秒" 或 "mutations:变更数"，格式不对或数值不为正时返回 false
+    static bool parse(std::string_view text, PersistPolicy& policy);
+};
+
+struct MealBatchResult {
+    bool success;
+    int deletedCount;
+    std::vector<Meal> inserted;   // 已分配ID的插入餐单
+};
 
 class Database {
 private:
     std::vector<User> users;
-    std::vector<Food> foods;
+    // 食物表以不可变目录的形式整体替换，餐单通过ID引用其中的食物
+    std::shared_ptr<const FoodCatalog> catalog;
+    // 删除餐单只清空所在的槽位（ID 置 0），不移动后面的元素；
+    // 空槽由压缩统一回收，回收后保持原有顺序
     std::vector<Meal> meals;
     
     std::string usersFile;
     std::string foodsFile;
     std::string mealsFile;
+    std::string snapshotFile;
+
+    // 读操作持共享锁，写操作持独占锁；后台压缩线程也通过它访问 meals
+    mutable std::shared_mutex mutex;
+
+    MealLog mealLog;
+    std::thread compactor;
+    std::mutex compactorMutex;
+    std::condition_variable compactorCv;
+    bool stopCompactor;
+    bool compactRequested;
+    std::mutex compactionMutex;
+
+    // 后台持久化线程；persistPolicy 和 pendingMutations 由 flusherMutex 保护
+    PersistPolicy persistPolicy;
+    std::thread flusher;
+    std::mutex flusherMutex;
+    std::condition_variable flusherCv;
+    bool stopFlusher;
+    size_t pendingMutations;
+    // users.txt / foods.txt 的脏标记在独占锁内置位，写文件由 fileMutex 串行化
+    std::atomic<bool> usersDirty;
+    std::atomic<bool> foodsDirty;
+    std::mutex fileMutex;
+
+    // 启动加载期间映射的二进制快照，loadMeals 结束后释放
+    SnapshotFile snapshot;
+    bool snapshotStale;
+
+    // 主键索引：id -> 在对应 vector 中的下标
+    std::unordered_map<int, size_t> userIndex;
+    std::unordered_map<int, size_t> mealIndex;
+    std::unordered_map<std::string, size_t> usernameIndex;
+    // 每个用户的餐单时间线，按 (日期, mealId) 排序；按天、按区间的查询都是二分查找
+    struct TimelineEntry {
+        int32_t day;
+        int mealId;
+
+        bool operator<(const TimelineEntry& other) const {
+            return day != other.day ? day < other.day : mealId < other.mealId;
+        }
+    };
+    using Timeline = std::vector<TimelineEntry>;
+    std::unordered_map<int, Timeline> userTimelines;
+    int maxUserId;
+    // 下一个分配的餐单ID，只增不减：删除后不会复用旧ID，客户端手里的旧ID不会指向别的餐单
+    int nextMealId;
+    size_t freeMealSlots;
 
-    std::vector<std::string> split(const std::string& str, char delimiter) const;
-    std::set<std::string> parseTagString(const std::string& tagStr) const;
+    void rebuildUserIndexes();
+    void installFoods(std::vector<Food> foods);
+    void rebuildMealIndexes();
+    void reindexMealPositions(size_t from);
+    void reclaimMealSlots();
+    void indexMeal(const Meal& meal);
+    void unindexMeal(const Meal& meal);
+    // 时间线中日期落在 [from, to] 内的区间
+    std::pair<Timeline::const_iterator, Timeline::const_iterator>
+        timelineRange(const Timeline& timeline, const Date& from, const Date& to) const;
+    std::vector<Meal> collectMeals(Timeline::const_iterator begin, Timeline::const_iterator end) const;
+
+    Meal parseMealFields(const std::vector<std::string_view>& tokens) const;
+    Meal parseMealLine(std::string_view line) const;
+
+    struct MealChunk {
+        std::vector<Meal> meals;
+        std::vector<std::string> errors;
+    };
+    MealChunk parseMealChunk(std::string_view chunk) const;
+    void parseMealBuffer(std::string_view buffer);
+    void applyMealUpsert(const Meal& meal);
+    bool applyMealDelete(int mealId);
+    std::vector<int> applyMealDeleteDay(const Date& date, int userId);
+    std::string serializeUsers() const;
+    std::string serializeFoods() const;
+    std::string serializeMeals() const;
+    bool openSnapshot();
+
+    void startCompactor();
+    void stopCompactorThread();
+    void compactorLoop();
+    bool compactMeals();
+    void notifyCompactorIfNeeded();
+
+    void startFlusher();
+    void stopFlusherThread();
+    void flusherLoop();
+    bool deferPersist();
+    bool flushTables();
+
+    // 逗号分隔的标签经由全局标签字典转换为掩码
+    TagMask parseTagString(std::string_view tagStr) const;
 
 public:
     Database();
     Database(const std::string& usersFile, const std::string& foodsFile, const std::string& mealsFile);
+    ~Database();
+
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
 
     bool loadUsers();
     bool loadFoods();
@@ -34,25 +200,50 @@ public:
     bool saveUsers();
     bool saveFoods();
     bool saveMeals();
+
+    // 切换持久化策略；从异步切走时先写出所有未落盘的变更
+    void setPersistPolicy(const PersistPolicy& policy);
+    PersistPolicy getPersistPolicy();
+    // 立即写出所有未落盘的变更（变更日志 fsync、用户与食物文件）
+    bool flush();
     
     bool saveUser(const User& user);
     bool updateUser(const User& user);
     bool saveMeal(const Meal& meal);
     bool deleteMeal(int mealId);
-    int deleteMealsByDateAndUser(const std::string& date, int userId);
+    int deleteMealsByDateAndUser(const Date& date, int userId);
     bool updateMeal(const Meal& meal);
+    MealBatchResult commitMealBatch(const MealBatch& batch);
     
     std::vector<User> getAllUsers() const;
     std::vector<Food> getAllFoods() const;
+    std::shared_ptr<const FoodCatalog> getFoodCatalog() const;
     std::vector<Meal> getAllMeals() const;
+
+    // 只读遍历：持共享锁依次回调内部记录，不复制整张表。
+    // 回调期间写操作会被阻塞，回调中不能再调用 Database 的写方法。
+    void forEachUser(const std::function<void(const User&)>& visit) const;
+    void forEachMeal(const std::function<void(const Meal&)>& visit) const;
+    // 按日期顺序遍历用户的餐单
+    void forEachMealOfUser(int userId, const std::function<void(const Meal&)>& visit) const;
+    void forEachMealOfUserInRange(int userId, const Date& from, const Date& to,
+                                  const std::function<void(const Meal&)>& visit) const;
     
+    // 按用户查询的结果按日期排序，同一天内按 mealId 排序
     std::vector<Meal> getMealsByUser(int userId) const;
-    std::vector<Meal> getMealsByDate(const std::string& date) const;
-    std::vector<Meal> getMealsByDateAndUser(const std::string& date, int userId) const;
+    std::vector<Meal> getMealsByDate(const Date& date) const;
+    std::vector<Meal> getMealsByDateAndUser(const Date& date, int userId) const;
+    // 日期在 [from, to] 内的餐单（含两端）
+    std::vector<Meal> getMealsByUserInRange(int userId, const Date& from, const Date& to) const;
+    // 日期在 [from, to] 内的餐单按 (日期, mealId) 从新到旧分页；
+    // before 非空时只返回严格早于该位置的餐单，limit 为 0 表示不限条数
+    MealPage getMealPageByUser(int userId, const Date& from, const Date& to, size_t limit,
+                               const std::optional<MealCursor>& before) const;
     std::optional<Meal> getMealById(int id) const;
     
     std::optional<Food> getFoodById(int id) const;
     std::optional<User> getUserById(int id) const;
+    std::optional<User> getUserByUsername(const std::string& username) const;
     
     int getNextUserId() const;
     int getNextFoodId() const;
@@ -0,0 +1,46 @@
+#ifndef DATE_H
+#define DATE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <optional>
+
+// 紧凑日期：以自 1970-01-01 起的天数保存，比较、排序和区间查询都是整数运算。
+// 文本形式固定为 "YYYY-MM-DD"，与数据文件和接口中的格式一致。
+class Date {
+private:
+    static const int32_t kInvalid = INT32_MIN;
+
+    int32_t days;
+
+    explicit Date(int32_t days) : days(days) {}
+
+public:
+    Date() : days(kInvalid) {}
+
+    static Date fromDays(int32_t days) { return Date(days); }
+    // 可表示的范围：0001-01-01 到 9999-12-31
+    static Date earliest();
+    static Date latest();
+    // 非法的年月日返回无效日期
+    static Date fromYmd(int year, int month, int day);
+    // 只接受 "YYYY-MM-DD"，格式或日期本身不合法时返回 std::nullopt
+    static std::optional<Date> parse(std::string_view str);
+
+    bool isValid() const { return days != kInvalid; }
+    int32_t toDays() const { return days; }
+    // 无效日期返回空字符串
+    std::string toString() const;
+
+    Date addDays(int32_t count) const { return isValid() ? Date(days + count) : *this; }
+
+    bool operator==(const Date& other) const { return days == other.days; }
+    bool operator!=(const Date& other) const { return days != other.days; }
+    bool operator<(const Date& other) const { return days < other.days; }
+    bool operator<=(const Date& other) const { return days <= other.days; }
+    bool operator>(const Date& other) const { return days > other.days; }
+    bool operator>=(const Date& other) const { return days >= other.days; }
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef FILE_SYNC_H
+#define FILE_SYNC_H
+
+#include <cstdio>
+#include <string>
+
+// 让写入真正落到磁盘的工具函数。
+// flush 只把数据交给操作系统，掉电或内核崩溃时仍会丢失；
+// 改名、创建和删除属于目录的修改，要同步所在目录后才持久。
+class FileSync {
+public:
+    // fflush 后 fsync（Windows 上为 _commit）
+    static bool syncStream(std::FILE* file);
+
+    // 按路径打开一个已写完的文件并 fsync
+    static bool syncFile(const std::string& path);
+
+    // fsync path 所在的目录；Windows 上没有对应操作，直接返回 true
+    static bool syncParentDirectory(const std::string& path);
+
+    // 写入临时文件并 fsync，改名覆盖 path，再同步目录。
+    // 返回 true 时新内容已持久，崩溃后读到的要么是旧文件要么是完整的新文件
+    static bool writeAtomically(const std::string& path, const std::string& content, bool binary = false);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <set>
+#include "TagDictionary.h"
 
 class Food {
 private:
@@ -14,7 +15,7 @@ private:
     double carbohydrates;     // 碳水化合物(g)
     double fat;               // 脂肪(g)
     double fiber;             // 纤维素(g)
-    std::set<std::string> tags; // 口味标签：辣、甜、咸、酸等
+    TagMask tags;             // 口味标签：辣、甜、咸、酸等
     std::string category;     // 类别：主食、蔬菜、肉类、水果等
 
 public:
@@ -22,6 +23,9 @@ public:
     Food(int id, const std::string& name, double cal, double prot, 
          double carb, double fat, double fiber, 
          const std::set<std::string>& tags, const std::string& category);
+    Food(int id, const std::string& name, double cal, double prot, 
+         double carb, double fat, double fiber, 
+         const TagMask& tags, const std::string& category);
 
     // Getters
     int getId() const { return id; }
@@ -31,7 +35,8 @@ public:
     double getCarbohydrates() const { return carbohydrates; }
     double getFat() const { return fat; }
     double getFiber() const { return fiber; }
-    std::set<std::string> getTags() const { return tags; }
+    std::set<std::string> getTags() const { return TagDictionary::instance().toSet(tags); }
+    const TagMask& getTagMask() const { return tags; }
     std::string getCategory() const { return category; }
 
     // Setters
@@ -42,7 +47,8 @@ public:
     void setCarbohydrates(double carb) { this->carbohydrates = carb; }
     void setFat(double fat) { this->fat = fat; }
     void setFiber(double fiber) { this->fiber = fiber; }
-    void setTags(const std::set<std::string>& tags) { this->tags = tags; }
+    void setTags(const std::set<std::string>& tags) { this->tags = TagDictionary::instance().toMask(tags); }
+    void setTagMask(const TagMask& tags) { this->tags = tags; }
     void setCategory(const std::string& cat) { this->category = cat; }
 
     void addTag(const std::string& tag);
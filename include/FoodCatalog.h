@@ -0,0 +1,111 @@
+#ifndef FOOD_CATALOG_H
+#define FOOD_CATALOG_H
+
+#include "Food.h"
+#include "TagDictionary.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+// 按 Alignment 字节对齐分配的分配器，供目录的数值列使用
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// 不可变的食物目录：构建后不再修改，可以在多个线程间共享。
+// 餐单只保存食物ID，名称、类别、标签和营养数据都从当前目录中查找；
+// 食物表变化时构建新目录并整体替换，持有旧目录的读者不受影响。
+//
+// 除了完整的 Food 记录，目录还按列（structure-of-arrays）保存打分用到的字段，
+// 每列 64 字节对齐、第 i 行对应 getFoods()[i]，候选扫描只顺序读取需要的列。
+class FoodCatalog {
+public:
+    static const size_t kColumnAlignment = 64;
+
+    template <typename T>
+    using Column = std::vector<T, AlignedAllocator<T, kColumnAlignment>>;
+
+private:
+    std::vector<Food> foods;
+    std::unordered_map<int, size_t> index;
+    int maxId;
+    uint64_t version;
+
+    Column<int> ids;
+    Column<double> calories;
+    Column<double> protein;
+    Column<double> carbohydrates;
+    Column<double> fat;
+    Column<double> fiber;
+    Column<int> categoryIds;
+    // 第 i 行的标签为 tagWords[i * tagStride ..)，只保存目录中用到的前 tagStride 个字
+    Column<uint64_t> tagWords;
+    int tagStride;
+    std::vector<std::string> categories;    // 类别ID -> 类别名，按首次出现的顺序编号
+
+public:
+    explicit FoodCatalog(std::vector<Food> foods);
+
+    FoodCatalog(const FoodCatalog&) = delete;
+    FoodCatalog& operator=(const FoodCatalog&) = delete;
+
+    const std::vector<Food>& getFoods() const { return foods; }
+    size_t size() const { return foods.size(); }
+    int getMaxId() const { return maxId; }
+    // 每个目录实例的版本号都不同，可用作缓存键的一部分
+    uint64_t getVersion() const { return version; }
+
+    // ID 不存在时返回 nullptr；ID 重复时第一个生效
+    const Food* find(int id) const;
+    // ID 不存在时返回 -1
+    int indexOf(int id) const;
+
+    // 列访问，长度均为 size()
+    const int* getIdColumn() const { return ids.data(); }
+    const double* getCalorieColumn() const { return calories.data(); }
+    const double* getProteinColumn() const { return protein.data(); }
+    const double* getCarbColumn() const { return carbohydrates.data(); }
+    const double* getFatColumn() const { return fat.data(); }
+    const double* getFiberColumn() const { return fiber.data(); }
+    const int* getCategoryColumn() const { return categoryIds.data(); }
+    // 标签列每行 getTagStride() 个字，长度为 size() * getTagStride()
+    const uint64_t* getTagColumn() const { return tagWords.data(); }
+    int getTagStride() const { return tagStride; }
+
+    size_t getCategoryCount() const { return categories.size(); }
+    const std::string& getCategoryName(int categoryId) const { return categories[categoryId]; }
+    // 未知类别返回 -1
+    int findCategory(const std::string& category) const;
+
+    // 进程内当前生效的目录，从未发布过时返回空目录
+    static std::shared_ptr<const FoodCatalog> current();
+    static void publish(std::shared_ptr<const FoodCatalog> catalog);
+};
+
+#endif
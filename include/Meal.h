@@ -2,17 +2,21 @@
 #define MEAL_H
 
 #include "Food.h"
+#include "Date.h"
 #include <vector>
 #include <string>
 #include <ctime>
 
+class FoodCatalog;
+
 class Meal {
 private:
     int id;
     int userId;
-    std::string date;
+    Date date;
     std::string mealType;  // breakfast, lunch, dinner, snack
-    std::vector<Food> foods;
+    std::vector<int> foodIds;  // 引用 FoodCatalog 中的食物
+    std::vector<double> portions;  // 与 foodIds 一一对应的份数，1 为目录中的一份
     double totalCalories;
     double totalProtein;
     double totalCarbs;
@@ -21,18 +25,25 @@ private:
 
 public:
     Meal();
+    // 字符串日期不是合法的 "YYYY-MM-DD" 时餐单日期无效
     Meal(int id, int userId, const std::string& date, const std::string& mealType);
+    Meal(int id, int userId, const Date& date, const std::string& mealType);
 
-    void addFood(const Food& food);
-    void removeFood(int foodId);
-    void calculateTotals();
+    void addFood(const Food& food, double portion = 1.0);
+    void removeFood(int foodId, const FoodCatalog& catalog);
+    // 按给定的食物目录重新计算营养总计
+    void calculateTotals(const FoodCatalog& catalog);
     
     // Getters
     int getId() const { return id; }
     int getUserId() const { return userId; }
-    std::string getDate() const { return date; }
+    std::string getDate() const { return date.toString(); }
+    const Date& getDay() const { return date; }
     std::string getMealType() const { return mealType; }
-    std::vector<Food> getFoods() const { return foods; }
+    // 从给定的食物目录解析出完整的食物信息，目录中已不存在的食物被跳过
+    std::vector<Food> getFoods(const FoodCatalog& catalog) const;
+    const std::vector<int>& getFoodIds() const { return foodIds; }
+    const std::vector<double>& getPortions() const { return portions; }
     double getTotalCalories() const { return totalCalories; }
     double getTotalProtein() const { return totalProtein; }
     double getTotalCarbs() const { return totalCarbs; }
@@ -42,11 +53,12 @@ public:
     // Setters
     void setId(int id) { this->id = id; }
     void setUserId(int userId) { this->userId = userId; }
-    void setDate(const std::string& date) { this->date = date; }
+    void setDate(const std::string& date) { this->date = Date::parse(date).value_or(Date()); }
+    void setDate(const Date& date) { this->date = date; }
     void setMealType(const std::string& type) { this->mealType = type; }
     void setIsRecommended(bool recommended) { this->isRecommended = recommended; }
 
-    void displayMeal() const;
+    void displayMeal(const FoodCatalog& catalog) const;
     std::string toString() const;
 };
 
@@ -0,0 +1,81 @@
+#ifndef MEAL_LOG_H
+#define MEAL_LOG_H
+
+#include "Meal.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+// 餐单变更的追加日志（write-ahead log）
+// 每条记录一行："I|<餐单行>" 插入，"U|<餐单行>" 更新，"D|<餐单ID>" 删除。
+// 多条记录组成的批次前面有一行 "B|<记录数>"，重放时不完整的批次整体丢弃。
+// 启动时在 meals.txt 快照之上按顺序重放；压缩时先把当前日志轮转为 .old，
+// 新快照落盘后再删除 .old，因此任意时刻崩溃都不会丢失已提交的记录。
+//
+// 提交采用组提交：enqueue 在调用方持有数据库锁时按变更顺序排队，
+// wait 在锁外等待落盘；同一时刻排队的多个批次由第一个等待者一次写入并 fsync。
+class MealLog {
+private:
+    struct FlushGroup {
+        bool done = false;
+        bool ok = false;
+    };
+
+    std::string logFile;
+    std::string rotatedFile;
+    FILE* out;
+    size_t recordCount;
+
+    std::mutex groupMutex;
+    std::condition_variable groupCv;
+    std::string pending;
+    std::shared_ptr<FlushGroup> openGroup;
+    bool flushing;
+
+    bool openLocked();
+    void closeLocked();
+    bool writeAndSync(const std::string& data);
+    void flushPendingLocked();
+    bool replayFile(const std::string& path,
+                    const std::function<void(char op, const std::string& payload)>& apply);
+
+public:
+    using Ticket = std::shared_ptr<FlushGroup>;
+
+    MealLog();
+    explicit MealLog(const std::string& logFile);
+    ~MealLog();
+
+    MealLog(const MealLog&) = delete;
+    MealLog& operator=(const MealLog&) = delete;
+
+    bool open();
+    void close();
+
+    static std::string insertRecord(const Meal& meal);
+    static std::string updateRecord(const Meal& meal);
+    static std::string deleteRecord(int mealId);
+
+    // 排队一组记录（多于一条时作为原子批次），返回用于等待落盘的凭据
+    Ticket enqueue(const std::vector<std::string>& records);
+    // 等待凭据对应的记录写入并 fsync，返回是否成功
+    bool wait(const Ticket& ticket);
+    // 写出并 fsync 目前已排队的所有记录
+    bool sync();
+
+    // 依次重放 .old 和当前日志，返回是否存在任何日志文件
+    bool replay(const std::function<void(char op, const std::string& payload)>& apply);
+
+    // 压缩第一步：写出所有排队记录后把当前日志移到 .old，并重新打开一个空日志
+    bool rotate();
+    // 压缩最后一步：新快照已落盘，丢弃 .old
+    void discardRotated();
+
+    size_t getRecordCount();
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef MEAL_TEMPLATES_H
+#define MEAL_TEMPLATES_H
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 餐的类型，推荐时按类型选用类别模板；其他类型的餐按加餐处理
+enum class MealKind { Breakfast, Lunch, Dinner, Snack };
+
+// 各类型餐的类别模板：(类别, 占该餐营养目标的比例)，按挑选顺序排列。
+// 默认值是编译期常量表；启动时可从配置文件覆盖部分餐类型，文件每行一种：
+//     餐类型|类别:比例,类别:比例,...
+// 例如 "breakfast|主食:0.4,蛋类:0.3,奶制品:0.3"。空行和以 '#' 开头的行被忽略，
+// 格式错误的行打印后跳过，文件中没有出现的餐类型沿用默认值。
+class MealTemplates {
+public:
+    static const size_t kKinds = 4;
+
+    struct Slot {
+        std::string category;
+        double share;
+    };
+
+private:
+    std::array<std::vector<Slot>, kKinds> slots;
+
+public:
+    // 默认模板
+    MealTemplates();
+
+    // 文件不存在或无法读取时返回 false，模板保持不变
+    bool loadFile(const std::string& path);
+
+    const std::vector<Slot>& get(MealKind kind) const { return slots[static_cast<size_t>(kind)]; }
+
+    // "breakfast" / "lunch" / "dinner"，其他（含 "snack"）为 Snack
+    static MealKind kindOf(std::string_view mealType);
+    static const char* nameOf(MealKind kind);
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef NUTRIENT_INDEX_H
+#define NUTRIENT_INDEX_H
+
+#include "FoodCatalog.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 食物营养向量（热量、蛋白质、碳水、脂肪）上的 k-d 树，按加权 L1 距离从近到远枚举目录行。
+// 各维权重随查询给出（例如打分时的 权重 / 目标值），树本身与权重无关；
+// 建树时按各维标准差归一化后的跨度选择分割维，使常见权重下树仍然平衡。
+// 构建后只读，可在多个线程上并发查询。
+class NutrientIndex {
+public:
+    static const int kDims = 4;
+
+private:
+    static const size_t kLeafSize = 8;
+
+    struct Node {
+        double lo[kDims];       // 子树内各维的最小值和最大值
+        double hi[kDims];
+        uint32_t begin;         // 子树在 rows / coords 中的范围
+        uint32_t end;
+        int32_t left;           // 叶子为 -1
+        int32_t right;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<size_t> rows;       // 目录行号，按树中顺序排列
+    std::vector<double> coords;     // 与 rows 对应的营养向量，每行 kDims 个
+
+    int32_t build(uint32_t begin, uint32_t end, const double* scale);
+
+public:
+    NutrientIndex() {}
+    // 只索引 rows 中的目录行
+    NutrientIndex(const FoodCatalog& catalog, const std::vector<size_t>& rows);
+
+    size_t size() const { return rows.size(); }
+
+    // 按 Σ weights[d] * |value[d] - query[d]| 从小到大依次调用 visit(目录行, 距离)，
+    // visit 返回 false 时停止。距离相同的行之间顺序不定
+    void forEachNearest(const double* query, const double* weights,
+                        const std::function<bool(size_t, double)>& visit) const;
+};
+
+#endif
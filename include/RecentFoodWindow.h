@@ -0,0 +1,46 @@
+#ifndef RECENT_FOOD_WINDOW_H
+#define RECENT_FOOD_WINDOW_H
+
+#include "Meal.h"
+#include <vector>
+#include <unordered_map>
+
+// 单个用户的推荐历史：按加入顺序保存每餐的食物ID，
+// 并对最近 kWindowSize 餐维护 食物ID -> 出现次数。
+// 加入或删除一餐只更新进出窗口的那几餐，代价与餐内食物数成正比。
+class RecentFoodWindow {
+public:
+    static constexpr size_t kWindowSize = 10;
+
+private:
+    struct Entry {
+        int mealId;
+        Date day;
+        std::vector<int> foodIds;
+    };
+
+    std::vector<Entry> meals;                // 最早加入的在前
+    std::unordered_map<int, int> counts;     // 窗口内 食物ID -> 出现次数
+
+    size_t windowStart() const;
+    void countMeal(const Entry& entry, int delta);
+    void removeAt(size_t position);
+
+public:
+    void add(const Meal& meal);
+    // 删除指定ID的餐，不存在时返回 false
+    bool remove(int mealId);
+    // 删除指定日期的所有餐，返回删除的数量
+    int removeDay(const Date& day);
+
+    // 最近 kWindowSize 餐内该食物出现的次数
+    int count(int foodId) const;
+    // 窗口内的餐数，即 min(size(), kWindowSize)
+    size_t windowSize() const;
+    size_t size() const { return meals.size(); }
+
+    // 只含窗口内各餐的副本，多样性计数与原窗口相同；用于在副本上试排后续几天
+    RecentFoodWindow recentOnly() const;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef RECOMMENDATION_CACHE_H
+#define RECOMMENDATION_CACHE_H
+
+#include "Meal.h"
+#include "User.h"
+#include "Date.h"
+#include "TagDictionary.h"
+#include "RecommendationEngine.h"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 生成结果只取决于这些输入：食物目录版本、用户推荐历史版本、生成方式，
+// 以及用户资料中参与打分的营养目标和标签
+struct PlanInputs {
+    uint64_t catalogVersion;
+    uint64_t historyVersion;
+    double calorieGoal;
+    double proteinGoal;
+    double carbGoal;
+    double fatGoal;
+    TagMask preferredTags;
+    TagMask avoidedTags;
+    TagMask allergens;
+    PlanMode mode;
+
+    static PlanInputs of(const User& user, uint64_t catalogVersion, uint64_t historyVersion,
+                         PlanMode mode = PlanMode::Greedy);
+
+    bool operator==(const PlanInputs& other) const;
+    bool operator!=(const PlanInputs& other) const { return !(*this == other); }
+};
+
+// 每日推荐的 LRU 缓存。每个 (用户, 日期) 最多一项，项中记录生成时的输入；
+// 查找时输入不一致即视为失效并丢弃，因此资料、历史或目录任一变化后不会命中旧结果。
+class RecommendationCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t invalidations;     // 因输入变化或显式失效而丢弃的项
+        size_t size;
+        size_t capacity;
+    };
+
+private:
+    struct Key {
+        int userId;
+        int32_t day;
+
+        bool operator==(const Key& other) const { return userId == other.userId && day == other.day; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<uint64_t>()((static_cast<uint64_t>(static_cast<uint32_t>(key.userId)) << 32) |
+                                         static_cast<uint32_t>(key.day));
+        }
+    };
+
+    struct Entry {
+        Key key;
+        PlanInputs inputs;
+        PlanResult plan;
+    };
+
+    size_t capacity;
+    std::list<Entry> entries;   // 最近使用的在前
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t invalidations;
+    mutable std::mutex mutex;
+
+public:
+    explicit RecommendationCache(size_t capacity = 1024);
+
+    // 命中时把缓存的推荐写入 plan 并返回 true
+    bool find(int userId, const Date& date, const PlanInputs& inputs, PlanResult& plan);
+    void store(int userId, const Date& date, const PlanInputs& inputs, const PlanResult& plan);
+    // 丢弃该用户的所有项
+    void invalidateUser(int userId);
+    void clear();
+
+    Stats getStats() const;
+};
+
+#endif
@@ -4,37 +4,156 @@
 #include "User.h"
 #include "Food.h"
 #include "Meal.h"
+#include "FoodCatalog.h"
+#include "MealTemplates.h"
+#include "ScoringKernel.h"
+#include "DailyPlanner.h"
+#include "NutrientIndex.h"
+#include "RecentFoodWindow.h"
+#include "ThreadPool.h"
+#include <array>
+#include <chrono>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+// 带时间预算的每日推荐结果
+struct PlanResult {
+    std::vector<Meal> meals;
+    // 全天营养达成度：1 减去四项营养相对偏差的平均值，不低于 0
+    double quality;
+    // 预算用完时提前结束，结果是已找到的最好方案但不一定最优
+    bool truncated;
+};
+
+// 打分用到的用户信息：由 User 编译一次，在多个请求、多个线程之间只读共享。
+// history 是编译时该用户推荐历史窗口的副本，historyVersion 为对应的历史版本
+struct ScoringProfile {
+    int userId;
+    uint64_t historyVersion;
+    ScoringKernel::Preferences preferences;
+    ScoringKernel::Targets dailyGoals;
+    std::shared_ptr<const RecentFoodWindow> history;
+
+    // 参与打分的目标和标签与 user 的当前资料一致
+    bool matches(const User& user) const;
+};
 
 class RecommendationEngine {
 private:
-    std::vector<Food> foodDatabase;
-    std::map<int, std::vector<Meal>> userHistory;  // userId -> meals
-
-    double calculateFoodScore(const Food& food, const User& user, 
-                              const std::string& mealType,
-                              double remainingCalories,
-                              double remainingProtein,
-                              double remainingCarbs,
-                              double remainingFat) const;
+    // 一日三餐各自占每日营养目标的比例
+    struct MealShare {
+        MealKind kind;
+        double calories;
+        double protein;
+        double carbs;
+        double fat;
+    };
+    static const MealShare kDailyMeals[3];
+
+    // 候选食物按目录中的行号引用，打分只读取目录的列
+    std::shared_ptr<const FoodCatalog> catalog;
+    // 目录类别ID -> 该类别的目录行号（按行号递增），更换目录时重建
+    std::vector<std::vector<size_t>> categoryCandidates;
+    // 编译后的类别模板，按 MealKind 下标取用：类别换成目录类别ID，目录中没有的类别已去掉。
+    // 更换目录或模板时重新编译
+    struct TemplateSlot {
+        int categoryId;
+        double share;
+    };
+    MealTemplates mealTemplates;
+    std::array<std::vector<TemplateSlot>, MealTemplates::kKinds> compiledTemplates;
+    // 替代食物查询用的营养近邻索引：全部食物一棵，每个类别一棵，与目录同时重建
+    NutrientIndex nutrientIndex;
+    std::vector<NutrientIndex> categoryNutrientIndexes;
+    std::unordered_map<int, RecentFoodWindow> userHistory;  // userId -> 推荐历史
+    // 请求线程并发打分时持共享锁读取历史，餐单增删时持独占锁增量更新
+    mutable std::shared_mutex historyMutex;
+    // 历史版本：每次修改某个用户的历史都取 historyClock 的新值；
+    // 整体载入后清空，未单独修改过的用户版本为 historyLoadedAt
+    std::unordered_map<int, uint64_t> historyVersions;
+    uint64_t historyClock;
+    uint64_t historyLoadedAt;
+    DailyPlanner::Options plannerOptions;
+    // userId -> 最近一次编译的打分资料，历史版本或资料变化后重新编译
+    mutable std::unordered_map<int, std::shared_ptr<const ScoringProfile>> profiles;
+    mutable std::mutex profileMutex;
+
+    void touchHistory(int userId);
+
+    // 多样性评分：按 history 中最近的餐单对 score 扣分后返回
+    static double applyDiversityPenalty(const RecentFoodWindow& history, int foodId, double score);
+    // 批量打分后加上多样性项，返回得分高于 -500 的前 k 个候选 (score, 行号)，
+    // 按分数从高到低，分数相同时目录中靠前的在前
+    std::vector<std::pair<double, size_t>> topCandidates(const ScoringProfile& profile, const std::vector<size_t>& rows,
+                                                         const ScoringKernel::Targets& targets, size_t k) const;
+    // 只读取 profile，可在多个线程上并发调用
+    Meal planMeal(const ScoringProfile& profile, MealKind kind,
+                  double targetCalories, double targetProtein,
+                  double targetCarbs, double targetFat) const;
+    
+    // 全天联合配餐，在 budgetMs 内改进 baseline；找不到更好的可行方案时返回空列表。
+    // complete 表示搜索在预算内完成
+    std::vector<Meal> planBalancedDay(const ScoringProfile& profile, PlanMode mode,
+                                      const std::vector<Meal>& baseline, double budgetMs, bool& complete) const;
     
-    std::vector<Food> filterFoodsByCategory(const std::string& category) const;
-    bool isAllergenFree(const Food& food, const User& user) const;
+    const std::vector<TemplateSlot>& templateFor(MealKind kind) const {
+        return compiledTemplates[static_cast<size_t>(kind)];
+    }
+    void rebuildCandidateIndex();
+    void compileTemplates();
 
 public:
     RecommendationEngine();
     
+    void setFoodCatalog(std::shared_ptr<const FoodCatalog> catalog);
     void setFoodDatabase(const std::vector<Food>& foods);
+    void setMealTemplates(const MealTemplates& templates);
     void addToHistory(int userId, const Meal& meal);
+    // 餐不存在时返回 false
+    bool removeFromHistory(int userId, int mealId);
+    // 删除该用户当天的全部历史餐单，再依次加入 meals；返回删除的数量
+    int replaceHistoryDay(int userId, const Date& day, const std::vector<Meal>& meals);
+    // 该用户的推荐历史每次变化后都会得到一个更大的版本号
+    uint64_t getHistoryVersion(int userId) const;
+    uint64_t getCatalogVersion() const { return catalog->getVersion(); }
     void loadHistory(const std::map<int, std::vector<Meal>>& history);
+    // 该用户的打分资料：历史版本和资料都未变时返回缓存的同一份，否则重新编译
+    std::shared_ptr<const ScoringProfile> profileFor(const User& user) const;
+    // 用户资料或会话变化时丢弃缓存的打分资料
+    void invalidateProfile(int userId);
+    // 默认的推荐时间预算（毫秒），超时返回已找到的最好方案
+    void setPlannerTimeBudget(double milliseconds) { plannerOptions.timeBudgetMs = milliseconds; }
+    double getPlannerTimeBudget() const { return plannerOptions.timeBudgetMs; }
     
-    std::vector<Meal> recommendDailyMeals(const User& user, const std::string& date);
+    // 使用默认时间预算
+    std::vector<Meal> recommendDailyMeals(const User& user, const std::string& date,
+                                          PlanMode mode = PlanMode::Greedy);
+    // 先逐餐挑选得到完整方案，非 Greedy 方式再在 deadline 之前做联合配餐改进；
+    // deadline 已过时直接返回逐餐挑选的结果并标记 truncated
+    PlanResult planDailyMeals(const User& user, const std::string& date, PlanMode mode,
+                              std::chrono::steady_clock::time_point deadline);
+    // 从 from 起连续 days 天的推荐，结果按 [用户][天][餐] 排列。
+    // 每天的多样性扣分会算上此前已排好的天；同一天内各用户、各餐在 pool 上并行生成。
+    // 结果与逐天调用 recommendDailyMeals 并把前一天的推荐加入历史相同，但不修改引擎中的历史。
+    std::vector<std::vector<std::vector<Meal>>> recommendBatch(const std::vector<User>& users,
+                                                               const Date& from, int days,
+                                                               ThreadPool& pool) const;
+    std::vector<std::vector<Meal>> recommendDays(const User& user, const Date& from, int days,
+                                                 ThreadPool& pool) const;
     Meal recommendMeal(const User& user, const std::string& mealType, 
                        double targetCalories, double targetProtein,
                        double targetCarbs, double targetFat);
     
-    std::vector<Food> getAlternativeFoods(const Food& food, const User& user, int count = 3);
+    // 与 food 营养最接近、得分最高的 count 种替代食物（不含 food 本身和含过敏原的食物），
+    // 按分数从高到低；sameCategory 为 true 时只在同类别中挑选。
+    // 结果与对全部候选打分后取前 count 个相同，但只对营养近邻逐个打分，
+    // 剩余候选的得分上界低于当前第 count 名时提前结束
+    std::vector<Food> getAlternativeFoods(const Food& food, const User& user, int count = 3,
+                                          bool sameCategory = false);
     
     void displayRecommendationStats(const std::vector<Meal>& meals);
 };
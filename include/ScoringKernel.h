@@ -0,0 +1,58 @@
+#ifndef SCORING_KERNEL_H
+#define SCORING_KERNEL_H
+
+#include "FoodCatalog.h"
+#include "TagDictionary.h"
+#include <cstddef>
+
+// 候选食物的批量打分：过敏原排除、喜好/避免标签加减分和营养平衡分，
+// 一次处理一整块候选行（不含依赖用户历史的多样性项）。
+//
+// 按 AVX2 / SSE4.2 / 标量三种实现在运行时选择 CPU 支持的最高一档。
+// 各实现按相同顺序做相同的 IEEE 双精度运算（不使用 FMA），
+// 因此结果与标量版本逐位一致，推荐结果不随机器变化。
+class ScoringKernel {
+public:
+    enum class Isa { Scalar, Sse42, Avx2 };
+
+    // 剩余营养目标，不大于 0 的项不参与营养平衡分
+    struct Targets {
+        double calories;
+        double protein;
+        double carbs;
+        double fat;
+    };
+
+    struct Preferences {
+        TagMask preferred;
+        TagMask avoided;
+        TagMask allergens;
+    };
+
+    // 含过敏原的食物得分
+    static constexpr double kExcludedScore = -1000.0;
+
+    // 对 rows[0..count) 指定的目录行打分，结果写入 scores[0..count)
+    static void scoreRows(const FoodCatalog& catalog, const size_t* rows, size_t count,
+                          const Preferences& preferences, const Targets& targets,
+                          double* scores);
+    // 对连续的目录行 [begin, end) 打分，结果写入 scores[0..end-begin)
+    static void scoreRange(const FoodCatalog& catalog, size_t begin, size_t end,
+                           const Preferences& preferences, const Targets& targets,
+                           double* scores);
+
+    // 营养平衡分中各项的权重。对目标为正的各项，营养平衡分等于
+    // 权重之和减去 Σ (权重 / 目标) * |取值 - 目标|，即加权 L1 距离
+    static Targets nutritionWeights();
+    // 得分上界：营养与目标完全一致、且命中用户全部喜好标签时的得分
+    static double maxScore(const Preferences& preferences, const Targets& targets);
+
+    // CPU 支持的最高一档
+    static Isa detectIsa();
+    static Isa getIsa();
+    // 强制使用指定实现（超过 CPU 支持时降到 detectIsa()），用于基准和排查
+    static void setIsa(Isa isa);
+    static const char* isaName(Isa isa);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef SNAPSHOT_FILE_H
+#define SNAPSHOT_FILE_H
+
+#include "User.h"
+#include "Food.h"
+#include "Meal.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// 二进制快照：定长记录 + 字符串表，启动时整体 mmap 后直接按记录读取，
+// 不再逐行解析文本。文本文件仍然是导入/导出格式：
+// 快照为每个分区记录了生成时对应文本文件的大小和修改时间，
+// 文本文件被改动过的分区会被视为过期，由调用方回退到文本解析。
+class SnapshotFile {
+public:
+    enum Section { UsersSection = 0, FoodsSection = 1, MealsSection = 2 };
+
+    struct SourceStamp {
+        uint64_t size;
+        int64_t mtime;
+    };
+
+    // 2：餐单日期改为按天数保存
+    // 3：餐单中的每个食物增加份数
+    static const uint32_t kVersion = 3;
+
+    static SourceStamp stampOf(const std::string& path);
+
+    // 生成快照内容；meals 分区的文本时间戳在 meals.txt 落盘后用 patchStamp 补上
+    static std::string build(const std::vector<User>& users,
+                             const std::vector<Food>& foods,
+                             const std::vector<Meal>& meals,
+                             const SourceStamp& usersStamp,
+                             const SourceStamp& foodsStamp);
+    static void patchStamp(std::string& buffer, Section section, const SourceStamp& stamp);
+
+private:
+    const char* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+
+    bool validate() const;
+
+public:
+    SnapshotFile();
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    // 对应文本文件自快照生成后未被修改时返回 true
+    bool isFresh(Section section, const std::string& textFile) const;
+
+    void decodeUsers(std::vector<User>& users) const;
+    void decodeFoods(std::vector<Food>& foods) const;
+    void decodeMeals(std::vector<Meal>& meals,
+                     const std::function<const Food*(int)>& findFood) const;
+};
+
+#endif
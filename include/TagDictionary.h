@@ -0,0 +1,121 @@
+#ifndef TAG_DICTIONARY_H
+#define TAG_DICTIONARY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <set>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+
+// 固定宽度的标签集合，每个位对应 TagDictionary 中的一个标签ID
+struct TagMask {
+    static constexpr int kBits = 256;
+    static constexpr int kWords = kBits / 64;
+
+    uint64_t bits[kWords] = {};
+
+    void set(int id) { bits[id >> 6] |= uint64_t(1) << (id & 63); }
+    void reset(int id) { bits[id >> 6] &= ~(uint64_t(1) << (id & 63)); }
+    bool test(int id) const { return (bits[id >> 6] >> (id & 63)) & 1; }
+    bool any() const {
+        uint64_t merged = 0;
+        for (uint64_t word : bits) merged |= word;
+        return merged != 0;
+    }
+    bool empty() const { return !any(); }
+    int count() const;
+
+    // 与按字存放的标签 words[0..count) 比较，只看前 count 个字（至少读取 words[0]）；
+    // 打分时两边超出各自已用字数的部分都为 0，不必整体比较
+    int countShared(const uint64_t* words, int count) const;
+    bool intersects(const uint64_t* words, int count) const;
+
+    static int popcount(uint64_t word);
+
+    TagMask operator&(const TagMask& other) const {
+        TagMask result;
+        for (int i = 0; i < kWords; ++i) result.bits[i] = bits[i] & other.bits[i];
+        return result;
+    }
+    TagMask operator|(const TagMask& other) const {
+        TagMask result;
+        for (int i = 0; i < kWords; ++i) result.bits[i] = bits[i] | other.bits[i];
+        return result;
+    }
+    bool operator==(const TagMask& other) const {
+        for (int i = 0; i < kWords; ++i) {
+            if (bits[i] != other.bits[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const TagMask& other) const { return !(*this == other); }
+};
+
+inline int TagMask::popcount(uint64_t word) {
+#if defined(_MSC_VER)
+    int total = 0;
+    while (word) {
+        word &= word - 1;
+        ++total;
+    }
+    return total;
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+inline int TagMask::count() const {
+    int total = 0;
+    for (uint64_t word : bits) total += popcount(word);
+    return total;
+}
+
+// 第 0 个字总是参与比较：count 为 0 时本掩码全为 0，结果不变，常见的单字情形也不必进入循环
+inline int TagMask::countShared(const uint64_t* words, int count) const {
+    int total = popcount(bits[0] & words[0]);
+    for (int i = 1; i < kWords; ++i) {
+        if (i < count) total += popcount(bits[i] & words[i]);
+    }
+    return total;
+}
+
+inline bool TagMask::intersects(const uint64_t* words, int count) const {
+    uint64_t merged = bits[0] & words[0];
+    for (int i = 1; i < kWords; ++i) {
+        if (i < count) merged |= bits[i] & words[i];
+    }
+    return merged != 0;
+}
+
+// 进程内全局的标签字典：把口味、过敏源等标签字符串驻留为 0..255 的小整数。
+// 标签只增不删，ID 在进程生命周期内保持不变；容量用完后无法再加入新标签。
+class TagDictionary {
+private:
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> names;   // deque 扩容时不移动已有元素，ids 的键可以直接引用
+    std::unordered_map<std::string_view, int> ids;
+
+    TagDictionary() = default;
+
+public:
+    static TagDictionary& instance();
+
+    TagDictionary(const TagDictionary&) = delete;
+    TagDictionary& operator=(const TagDictionary&) = delete;
+
+    // 返回标签ID；字典已满且 tag 不在其中时抛出 std::length_error
+    int intern(std::string_view tag);
+    // 只查找不驻留，未知标签返回 -1
+    int find(std::string_view tag) const;
+
+    // 逐个 intern，字典已满时抛出 std::length_error
+    TagMask toMask(const std::set<std::string>& tags);
+    // 按字符串顺序返回掩码中的标签，与 std::set<std::string> 的遍历顺序一致
+    std::vector<std::string> toNames(const TagMask& mask) const;
+    std::set<std::string> toSet(const TagMask& mask) const;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef TEXT_PARSER_H
+#define TEXT_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 面向 '|' / ',' 分隔数据文件的零拷贝解析工具。
+// 整个文件一次读入缓冲区，行和字段都是指向该缓冲区的 string_view，
+// 数值通过 std::from_chars 直接从切片解析，不产生临时字符串。
+class TextParser {
+public:
+    // 逐行遍历缓冲区，去掉行尾的 '\r'
+    class LineReader {
+    private:
+        std::string_view buffer;
+        size_t pos;
+
+    public:
+        explicit LineReader(std::string_view buffer) : buffer(buffer), pos(0) {}
+        bool next(std::string_view& line);
+    };
+
+    static bool readFile(const std::string& path, std::string& buffer);
+
+    // 与 std::getline 逐段切分的结果一致：末尾的空字段不计入
+    static size_t split(std::string_view str, char delimiter, std::vector<std::string_view>& fields);
+
+    // 与 std::stoi / std::stod 一致：允许前导空白，忽略数字之后的内容；
+    // 没有可解析的数字时抛出 std::invalid_argument
+    static int toInt(std::string_view str);
+    static double toDouble(std::string_view str);
+};
+
+#endif
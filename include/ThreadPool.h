@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <type_traits>
+
+// 固定大小的工作线程池，submit 返回 future 以便调用方按提交顺序收集结果。
+// 每个工作线程有自己的任务队列：外部提交的任务轮流放入各队列，
+// 工作线程内部提交的任务放在自己队列的前端；线程优先从自己队列前端取任务，
+// 空闲时从其他队列的后端窃取，任务耗时不均时各线程的负载也能摊平。
+class ThreadPool {
+private:
+    struct WorkerQueue {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue;
+    // pending 为已提交、尚未被取走的任务数，在 sleepMutex 下增加以免漏掉唤醒
+    std::atomic<size_t> pending;
+    std::mutex sleepMutex;
+    std::condition_variable cv;
+    bool stopping;
+
+    void push(std::function<void()> task);
+    bool tryPop(size_t index, std::function<void()>& task);
+    void workerLoop(size_t index);
+
+public:
+    // threadCount 为 0 时使用硬件并发数
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    template <typename F>
+    std::future<typename std::invoke_result<F>::type> submit(F&& task) {
+        using Result = typename std::invoke_result<F>::type;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        push([packaged]() { (*packaged)(); });
+        return result;
+    }
+};
+
+#endif
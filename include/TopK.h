@@ -0,0 +1,60 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 容量固定的 top-k 选择器：只保留 better 意义下最好的 k 个元素。
+// 内部是以当前最差元素为堆顶的二叉堆，每次 push 为 O(log k)。
+// better 须为严格全序（分数相同时再比较其他字段），结果才与输入顺序无关。
+template <typename T, typename Better>
+class TopK {
+private:
+    size_t capacity;
+    std::vector<T> heap;
+    Better better;
+
+public:
+    explicit TopK(size_t k, Better better = Better()) : capacity(k), better(better) {
+        heap.reserve(k);
+    }
+
+    void push(const T& item) {
+        if (capacity == 0) {
+            return;
+        }
+        if (heap.size() < capacity) {
+            heap.push_back(item);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(item, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = item;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    size_t size() const { return heap.size(); }
+    bool full() const { return heap.size() == capacity; }
+    // 当前保留的最差元素，须非空
+    const T& worst() const { return heap.front(); }
+
+    // 取出结果，最好的在前；之后选择器为空
+    std::vector<T> take() {
+        std::sort_heap(heap.begin(), heap.end(), better);
+        std::vector<T> result;
+        result.swap(heap);
+        return result;
+    }
+};
+
+// 按分数从高到低，分数相同时按 ID（或行号）从小到大
+struct HigherScoreFirst {
+    template <typename Score, typename Id>
+    bool operator()(const std::pair<Score, Id>& a, const std::pair<Score, Id>& b) const {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    }
+};
+
+#endif
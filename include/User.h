@@ -5,6 +5,7 @@
 #include <vector>
 #include <set>
 #include <map>
+#include "TagDictionary.h"
 
 class User {
 private:
@@ -22,9 +23,9 @@ private:
     double dailyCarbGoal;     // 每日碳水目标(g)
     double dailyFatGoal;      // 每日脂肪目标(g)
     
-    std::set<std::string> preferredTags;  // 喜欢的口味标签
-    std::set<std::string> avoidedTags;    // 避免的口味标签
-    std::set<std::string> allergens;      // 过敏源
+    TagMask preferredTags;    // 喜欢的口味标签
+    TagMask avoidedTags;      // 避免的口味标签
+    TagMask allergens;        // 过敏源
 
 public:
     User();
@@ -43,9 +44,12 @@ public:
     double getDailyProteinGoal() const { return dailyProteinGoal; }
     double getDailyCarbGoal() const { return dailyCarbGoal; }
     double getDailyFatGoal() const { return dailyFatGoal; }
-    std::set<std::string> getPreferredTags() const { return preferredTags; }
-    std::set<std::string> getAvoidedTags() const { return avoidedTags; }
-    std::set<std::string> getAllergens() const { return allergens; }
+    std::set<std::string> getPreferredTags() const { return TagDictionary::instance().toSet(preferredTags); }
+    std::set<std::string> getAvoidedTags() const { return TagDictionary::instance().toSet(avoidedTags); }
+    std::set<std::string> getAllergens() const { return TagDictionary::instance().toSet(allergens); }
+    const TagMask& getPreferredTagMask() const { return preferredTags; }
+    const TagMask& getAvoidedTagMask() const { return avoidedTags; }
+    const TagMask& getAllergenMask() const { return allergens; }
 
     // Setters
     void setId(int id) { this->id = id; }
@@ -60,6 +64,9 @@ public:
     void setDailyProteinGoal(double prot) { this->dailyProteinGoal = prot; }
     void setDailyCarbGoal(double carb) { this->dailyCarbGoal = carb; }
     void setDailyFatGoal(double fat) { this->dailyFatGoal = fat; }
+    void setPreferredTagMask(const TagMask& tags) { this->preferredTags = tags; }
+    void setAvoidedTagMask(const TagMask& tags) { this->avoidedTags = tags; }
+    void setAllergenMask(const TagMask& tags) { this->allergens = tags; }
 
     void addPreferredTag(const std::string& tag);
     void addAvoidedTag(const std::string& tag);
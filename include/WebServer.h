@@ -3,34 +3,53 @@
 
 #include "Database.h"
 #include "RecommendationEngine.h"
+#include "RecommendationCache.h"
+#include "ThreadPool.h"
 #include "User.h"
 #include <string>
 #include <memory>
 #include <map>
+#include <atomic>
 
 class WebServer {
 private:
     Database db;
     RecommendationEngine engine;
+    RecommendationCache planCache;
+    // 批量推荐在这里并行生成
+    ThreadPool planPool;
+    // 正在生成的每日推荐数，并发高时按比例缩短每个请求的时间预算
+    std::atomic<int> activePlans;
     std::map<std::string, User> sessions;
     int port;
     std::string wwwRoot;
 
     std::string generateSessionToken();
-    std::string createJsonResponse(bool success, const std::string& message, const std::string& data = "");
+    // extraFields 为附加在顶层的 JSON 成员（不含外层花括号），例如分页游标
+    std::string createJsonResponse(bool success, const std::string& message, const std::string& data = "",
+                                   const std::string& extraFields = "");
     std::string userToJson(const User& user);
-    std::string foodToJson(const Food& food);
-    std::string mealToJson(const Meal& meal);
+    // extraFields 为附加在食物对象内的 JSON 成员，例如餐单中的份数
+    std::string foodToJson(const Food& food, const std::string& extraFields = "");
+    std::string mealToJson(const Meal& meal, const FoodCatalog& catalog);
     std::string foodsArrayToJson(const std::vector<Food>& foods);
     std::string mealsArrayToJson(const std::vector<Meal>& meals);
     std::string parseJsonString(const std::string& json, const std::string& key);
     int parseJsonInt(const std::string& json, const std::string& key);
     double parseJsonDouble(const std::string& json, const std::string& key);
+    // 整数数组，如 "userIds": [1, 2]；键不存在时 values 为空并返回 true，格式不对返回 false
+    bool parseJsonIntArray(const std::string& json, const std::string& key, std::vector<int>& values);
     std::string urlDecode(const std::string& str);
+    // 启动时把数据库中的全部餐单载入推荐引擎，之后由各接口增量更新
     void reloadEngineHistory();
+    // 当天的推荐：输入未变时复用缓存，预览和保存拿到同一份结果。
+    // budgetMs 为 0 时使用默认预算；reuseTruncated 为 false 时不复用预算不足时得到的结果
+    PlanResult dailyPlan(const User& user, const Date& day, const std::string& date, PlanMode mode,
+                         int budgetMs, bool reuseTruncated);
 
 public:
-    WebServer(int port = 8000, const std::string& wwwRoot = "www");
+    WebServer(int port = 8000, const std::string& wwwRoot = "www",
+              const PersistPolicy& persistPolicy = PersistPolicy::sync());
     void start();
     void openBrowser(const std::string& url);
 };
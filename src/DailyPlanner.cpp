@@ -0,0 +1,244 @@
+#include "../include/DailyPlanner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int kMacros = 4;  // 热量、蛋白质、碳水、脂肪
+
+struct Item {
+    size_t row;
+    double portion;
+    double macros[kMacros];
+    double cost;
+};
+
+struct Level {
+    size_t slot;
+    std::vector<Item> items;
+};
+
+struct Child {
+    double guide;   // 排序用的估计值
+    double bound;   // 剪枝用的下界
+    size_t item;
+};
+
+class Search {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    const std::vector<Level>& levels;
+    double goal[kMacros];
+    double weight[kMacros];     // 1 / 目标值，偏差按相对值计
+    // 第 depth 层及之后所有槽位的营养最小和、最大和、平均和，以及最小附加代价之和
+    std::vector<double> suffixMin;
+    std::vector<double> suffixMax;
+    std::vector<double> suffixMean;
+    std::vector<double> suffixCost;
+    bool distinct;
+    std::vector<char> used;
+    Clock::time_point deadline;
+    std::vector<std::vector<Child>> scratch;
+    std::vector<size_t> current;
+
+public:
+    std::vector<size_t> best;
+    double bestObjective;
+    uint64_t nodes;
+    bool truncated;
+
+    Search(const std::vector<Level>& levels, const ScoringKernel::Targets& goals, size_t rowCount,
+           const DailyPlanner::Options& options)
+        : levels(levels), distinct(options.distinctFoods), used(rowCount, 0),
+          deadline(Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double, std::milli>(options.timeBudgetMs))),
+          scratch(levels.size()), current(levels.size()),
+          bestObjective(options.incumbent), nodes(0), truncated(false) {
+        const double targets[kMacros] = {goals.calories, goals.protein, goals.carbs, goals.fat};
+        for (int m = 0; m < kMacros; ++m) {
+            goal[m] = targets[m];
+            weight[m] = targets[m] > 0 ? 1.0 / targets[m] : 0.0;
+        }
+
+        size_t n = levels.size();
+        suffixMin.assign((n + 1) * kMacros, 0.0);
+        suffixMax.assign((n + 1) * kMacros, 0.0);
+        suffixMean.assign((n + 1) * kMacros, 0.0);
+        suffixCost.assign(n + 1, 0.0);
+        for (size_t depth = n; depth-- > 0;) {
+            const std::vector<Item>& items = levels[depth].items;
+            double minCost = items[0].cost;
+            for (int m = 0; m < kMacros; ++m) {
+                double lo = items[0].macros[m];
+                double hi = items[0].macros[m];
+                double sum = 0.0;
+                for (const Item& item : items) {
+                    lo = std::min(lo, item.macros[m]);
+                    hi = std::max(hi, item.macros[m]);
+                    sum += item.macros[m];
+                }
+                suffixMin[depth * kMacros + m] = suffixMin[(depth + 1) * kMacros + m] + lo;
+                suffixMax[depth * kMacros + m] = suffixMax[(depth + 1) * kMacros + m] + hi;
+                suffixMean[depth * kMacros + m] = suffixMean[(depth + 1) * kMacros + m] + sum / items.size();
+            }
+            for (const Item& item : items) {
+                minCost = std::min(minCost, item.cost);
+            }
+            suffixCost[depth] = suffixCost[depth + 1] + minCost;
+        }
+    }
+
+    // 已选部分的营养为 totals、代价为 cost 时，完整方案目标值的下界
+    double bound(const double* totals, double cost, size_t depth) const {
+        double result = cost + suffixCost[depth];
+        for (int m = 0; m < kMacros; ++m) {
+            double need = goal[m] - totals[m];
+            double lo = suffixMin[depth * kMacros + m];
+            double hi = suffixMax[depth * kMacros + m];
+            if (need < lo) {
+                result += weight[m] * (lo - need);
+            } else if (need > hi) {
+                result += weight[m] * (need - hi);
+            }
+        }
+        return result;
+    }
+
+    double guide(const double* totals, double cost, size_t depth) const {
+        double result = cost;
+        for (int m = 0; m < kMacros; ++m) {
+            result += weight[m] * std::fabs(goal[m] - totals[m] - suffixMean[depth * kMacros + m]);
+        }
+        return result;
+    }
+
+    void run(size_t depth, const double* totals, double cost) {
+        // 每个节点都要为所有候选计算下界，相比之下读时钟的开销可以忽略
+        ++nodes;
+        if (Clock::now() > deadline) {
+            truncated = true;
+        }
+        if (truncated) {
+            return;
+        }
+        if (depth == levels.size()) {
+            double objective = bound(totals, cost, depth);
+            if (objective < bestObjective) {
+                bestObjective = objective;
+                best = current;
+            }
+            return;
+        }
+
+        const std::vector<Item>& items = levels[depth].items;
+        std::vector<Child>& children = scratch[depth];
+        children.clear();
+        double next[kMacros];
+        for (size_t i = 0; i < items.size(); ++i) {
+            const Item& item = items[i];
+            if (distinct && used[item.row]) {
+                continue;
+            }
+            for (int m = 0; m < kMacros; ++m) {
+                next[m] = totals[m] + item.macros[m];
+            }
+            double childBound = bound(next, cost + item.cost, depth + 1);
+            if (childBound < bestObjective) {
+                children.push_back({guide(next, cost + item.cost, depth + 1), childBound, i});
+            }
+        }
+        std::sort(children.begin(), children.end(), [](const Child& a, const Child& b) {
+            return a.guide < b.guide || (a.guide == b.guide && a.item < b.item);
+        });
+
+        for (const Child& child : children) {
+            // 兄弟分支可能已经找到了更好的解
+            if (child.bound >= bestObjective) {
+                continue;
+            }
+            const Item& item = items[child.item];
+            for (int m = 0; m < kMacros; ++m) {
+                next[m] = totals[m] + item.macros[m];
+            }
+            used[item.row] = 1;
+            current[depth] = child.item;
+            run(depth + 1, next, cost + item.cost);
+            used[item.row] = 0;
+            if (truncated) {
+                return;
+            }
+        }
+    }
+};
+
+}
+
+double DailyPlanner::deviation(const ScoringKernel::Targets& totals, const ScoringKernel::Targets& goals) {
+    const double values[kMacros] = {totals.calories, totals.protein, totals.carbs, totals.fat};
+    const double targets[kMacros] = {goals.calories, goals.protein, goals.carbs, goals.fat};
+    double result = 0.0;
+    for (int m = 0; m < kMacros; ++m) {
+        double weight = targets[m] > 0 ? 1.0 / targets[m] : 0.0;
+        result += weight * std::fabs(targets[m] - values[m]);
+    }
+    return result;
+}
+
+DailyPlanner::Result DailyPlanner::solve(const FoodCatalog& catalog, const std::vector<Slot>& slots,
+                                         const ScoringKernel::Targets& goals, const Options& options) {
+    const double* columns[kMacros] = {catalog.getCalorieColumn(), catalog.getProteinColumn(),
+                                      catalog.getCarbColumn(), catalog.getFatColumn()};
+    std::vector<Level> levels;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        if (slots[s].candidates.empty() || options.portions.empty()) {
+            continue;
+        }
+        Level level;
+        level.slot = s;
+        level.items.reserve(slots[s].candidates.size() * options.portions.size());
+        for (const Candidate& candidate : slots[s].candidates) {
+            for (double portion : options.portions) {
+                Item item;
+                item.row = candidate.row;
+                item.portion = portion;
+                for (int m = 0; m < kMacros; ++m) {
+                    item.macros[m] = columns[m][candidate.row] * portion;
+                }
+                item.cost = candidate.cost;
+                level.items.push_back(item);
+            }
+        }
+        levels.push_back(std::move(level));
+    }
+
+    // 热量取值范围大的槽位先定，后面的槽位区间更窄，下界更紧
+    auto calorieRange = [](const Level& level) {
+        auto bounds = std::minmax_element(level.items.begin(), level.items.end(), [](const Item& a, const Item& b) {
+            return a.macros[0] < b.macros[0];
+        });
+        return bounds.second->macros[0] - bounds.first->macros[0];
+    };
+    std::stable_sort(levels.begin(), levels.end(), [&calorieRange](const Level& a, const Level& b) {
+        return calorieRange(a) > calorieRange(b);
+    });
+
+    Search search(levels, goals, catalog.size(), options);
+    const double zero[kMacros] = {0.0, 0.0, 0.0, 0.0};
+    search.run(0, zero, 0.0);
+
+    Result result;
+    result.objective = search.bestObjective;
+    result.complete = !search.truncated;
+    result.nodes = search.nodes;
+    if (search.best.size() == levels.size() && search.bestObjective < options.incumbent) {
+        result.choices.assign(slots.size(), Choice{0, 0.0});
+        for (size_t depth = 0; depth < levels.size(); ++depth) {
+            const Item& item = levels[depth].items[search.best[depth]];
+            result.choices[levels[depth].slot] = {item.row, item.portion};
+        }
+    }
+    return result;
+}
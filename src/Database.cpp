@@ -1,122 +1,494 @@
 #include "../include/Database.h"
+#include "../include/TextParser.h"
+#include "../include/ThreadPool.h"
+#include "../include/FileSync.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <optional>
+#include <filesystem>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
 
-Database::Database() : usersFile("data/users.txt"), 
+namespace {
+// 日志记录数达到 max(最小阈值, 当前餐单数) 时触发压缩，
+// 压缩的整体重写代价因此摊到每条变更上是常数
+const size_t kMinCompactRecords = 1000;
+const auto kCompactInterval = std::chrono::seconds(30);
+// 小于该大小的餐单文件直接在当前线程解析
+const size_t kMinParallelParseBytes = 1 << 20;
+
+bool isFreeSlot(const Meal& meal) {
+    return meal.getId() == 0;
+}
+}
+
+bool PersistPolicy::parse(std::string_view text, PersistPolicy& policy) {
+    if (text == "sync") {
+        policy = sync();
+        return true;
+    }
+    size_t sep = text.find(':');
+    if (sep == std::string_view::npos) {
+        return false;
+    }
+    int value = 0;
+    try {
+        value = TextParser::toInt(text.substr(sep + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (value <= 0) {
+        return false;
+    }
+    std::string_view mode = text.substr(0, sep);
+    if (mode == "interval") {
+        policy = interval(value);
+        return true;
+    }
+    if (mode == "mutations") {
+        policy = everyMutations(static_cast<size_t>(value));
+        return true;
+    }
+    return false;
+}
+
+Database::Database() : catalog(std::make_shared<const FoodCatalog>(std::vector<Food>())),
+                       usersFile("data/users.txt"), 
                        foodsFile("data/foods.txt"),
-                       mealsFile("data/meals.txt") {}
+                       mealsFile("data/meals.txt"),
+                       snapshotFile("data/snapshot.bin"),
+                       mealLog("data/meals.txt.wal"),
+                       stopCompactor(false), compactRequested(false),
+                       persistPolicy(PersistPolicy::sync()), stopFlusher(false), pendingMutations(0),
+                       usersDirty(false), foodsDirty(false),
+                       snapshotStale(false),
+                       maxUserId(0), nextMealId(1), freeMealSlots(0) {}
 
 Database::Database(const std::string& usersFile, const std::string& foodsFile, const std::string& mealsFile)
-    : usersFile(usersFile), foodsFile(foodsFile), mealsFile(mealsFile) {}
+    : catalog(std::make_shared<const FoodCatalog>(std::vector<Food>())),
+      usersFile(usersFile), foodsFile(foodsFile), mealsFile(mealsFile),
+      snapshotFile((std::filesystem::path(mealsFile).parent_path() / "snapshot.bin").string()),
+      mealLog(mealsFile + ".wal"),
+      stopCompactor(false), compactRequested(false),
+      persistPolicy(PersistPolicy::sync()), stopFlusher(false), pendingMutations(0),
+      usersDirty(false), foodsDirty(false),
+      snapshotStale(false),
+      maxUserId(0), nextMealId(1), freeMealSlots(0) {}
+
+Database::~Database() {
+    // 先写出后台线程尚未落盘的变更，再停止压缩
+    stopFlusherThread();
+    stopCompactorThread();
+}
 
-std::vector<std::string> Database::split(const std::string& str, char delimiter) const {
-    std::vector<std::string> tokens;
-    std::stringstream ss(str);
-    std::string token;
-    while (std::getline(ss, token, delimiter)) {
-        tokens.push_back(token);
+void Database::startFlusher() {
+    if (flusher.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(flusherMutex);
+        stopFlusher = false;
     }
-    return tokens;
+    flusher = std::thread(&Database::flusherLoop, this);
 }
 
-std::set<std::string> Database::parseTagString(const std::string& tagStr) const {
-    std::set<std::string> tags;
-    if (tagStr.empty()) return tags;
-    
-    auto tokens = split(tagStr, ',');
-    for (const auto& token : tokens) {
-        if (!token.empty()) {
-            tags.insert(token);
+void Database::stopFlusherThread() {
+    {
+        std::lock_guard<std::mutex> lock(flusherMutex);
+        stopFlusher = true;
+    }
+    flusherCv.notify_all();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    flush();
+}
+
+void Database::flusherLoop() {
+    std::unique_lock<std::mutex> lock(flusherMutex);
+    while (!stopFlusher) {
+        if (persistPolicy.mode == PersistPolicy::Mode::Interval) {
+            flusherCv.wait_for(lock, std::chrono::milliseconds(std::max(1, persistPolicy.intervalMs)),
+                               [this] { return stopFlusher; });
+        } else {
+            size_t threshold = std::max<size_t>(1, persistPolicy.mutationThreshold);
+            flusherCv.wait(lock, [this, threshold] { return stopFlusher || pendingMutations >= threshold; });
+        }
+        // 停止时由 stopFlusherThread 统一写出剩余变更
+        if (stopFlusher || pendingMutations == 0) continue;
+
+        pendingMutations = 0;
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+bool Database::deferPersist() {
+    std::lock_guard<std::mutex> lock(flusherMutex);
+    if (persistPolicy.mode == PersistPolicy::Mode::Sync) {
+        return false;
+    }
+    ++pendingMutations;
+    if (persistPolicy.mode == PersistPolicy::Mode::Mutations &&
+        pendingMutations >= std::max<size_t>(1, persistPolicy.mutationThreshold)) {
+        flusherCv.notify_one();
+    }
+    return true;
+}
+
+void Database::setPersistPolicy(const PersistPolicy& policy) {
+    stopFlusherThread();
+    {
+        std::lock_guard<std::mutex> lock(flusherMutex);
+        persistPolicy = policy;
+        pendingMutations = 0;
+    }
+    if (policy.mode != PersistPolicy::Mode::Sync) {
+        startFlusher();
+    }
+}
+
+PersistPolicy Database::getPersistPolicy() {
+    std::lock_guard<std::mutex> lock(flusherMutex);
+    return persistPolicy;
+}
+
+bool Database::flush() {
+    bool ok = mealLog.sync();
+    if (!ok) {
+        std::cout << "Error syncing meal log: " << mealsFile << std::endl;
+    }
+    return flushTables() && ok;
+}
+
+bool Database::flushTables() {
+    // fileMutex 保证按序列化的先后顺序写文件，较旧的内容不会覆盖较新的
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    bool writeUsers = usersDirty.exchange(false);
+    bool writeFoods = foodsDirty.exchange(false);
+    if (!writeUsers && !writeFoods) {
+        return true;
+    }
+
+    std::string usersContent;
+    std::string foodsContent;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (writeUsers) usersContent = serializeUsers();
+        if (writeFoods) foodsContent = serializeFoods();
+    }
+
+    bool ok = true;
+    if (writeUsers && !FileSync::writeAtomically(usersFile, usersContent)) {
+        std::cout << "Error writing users file: " << usersFile << std::endl;
+        usersDirty = true;
+        ok = false;
+    }
+    if (writeFoods && !FileSync::writeAtomically(foodsFile, foodsContent)) {
+        std::cout << "Error writing foods file: " << foodsFile << std::endl;
+        foodsDirty = true;
+        ok = false;
+    }
+    return ok;
+}
+
+void Database::startCompactor() {
+    if (compactor.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(compactorMutex);
+        stopCompactor = false;
+    }
+    compactor = std::thread(&Database::compactorLoop, this);
+}
+
+void Database::stopCompactorThread() {
+    {
+        std::lock_guard<std::mutex> lock(compactorMutex);
+        stopCompactor = true;
+    }
+    compactorCv.notify_all();
+    if (compactor.joinable()) {
+        compactor.join();
+    }
+}
+
+void Database::notifyCompactorIfNeeded() {
+    if (mealLog.getRecordCount() >= std::max(kMinCompactRecords, meals.size() - freeMealSlots)) {
+        // 调用方持有数据锁；压缩线程不会在持有 compactorMutex 时等待数据锁，这里的加锁顺序是安全的
+        {
+            std::lock_guard<std::mutex> compactorLock(compactorMutex);
+            compactRequested = true;
         }
+        compactorCv.notify_one();
+    }
+}
+
+void Database::compactorLoop() {
+    std::unique_lock<std::mutex> lock(compactorMutex);
+    while (!stopCompactor) {
+        compactorCv.wait_for(lock, kCompactInterval, [this] { return stopCompactor || compactRequested; });
+        if (stopCompactor) break;
+
+        bool needed = compactRequested;
+        compactRequested = false;
+        // 写入方持有数据锁时会获取 compactorMutex，因此先释放它再读取数据
+        lock.unlock();
+        {
+            std::shared_lock<std::shared_mutex> dataLock(mutex);
+            needed = needed || mealLog.getRecordCount() >= std::max(kMinCompactRecords, meals.size() - freeMealSlots);
+        }
+        if (needed) {
+            compactMeals();
+        }
+        lock.lock();
+    }
+}
+
+bool Database::compactMeals() {
+    std::lock_guard<std::mutex> compactionLock(compactionMutex);
+    std::string textSnapshot;
+    std::string binarySnapshot;
+    {
+        // 持有 fileMutex 时 users.txt / foods.txt 不会被改写，
+        // 快照中的用户和食物不会比时间戳对应的文件更旧
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (!mealLog.rotate()) {
+            std::cout << "Error rotating meal log: " << mealsFile << std::endl;
+            return false;
+        }
+        reclaimMealSlots();
+        textSnapshot = serializeMeals();
+        binarySnapshot = SnapshotFile::build(users, catalog->getFoods(), meals,
+                                             SnapshotFile::stampOf(usersFile),
+                                             SnapshotFile::stampOf(foodsFile));
+    }
+
+    // 快照写入在锁外进行，期间新的变更继续追加到新日志。
+    // meals.txt 连同目录项落盘之后才能删除旧日志，否则崩溃时两边都可能丢失
+    if (!FileSync::writeAtomically(mealsFile, textSnapshot)) {
+        std::cout << "Error writing meal snapshot: " << mealsFile << std::endl;
+        return false;
+    }
+    SnapshotFile::patchStamp(binarySnapshot, SnapshotFile::MealsSection, SnapshotFile::stampOf(mealsFile));
+    if (!FileSync::writeAtomically(snapshotFile, binarySnapshot, true)) {
+        std::cout << "Error writing binary snapshot: " << snapshotFile << std::endl;
+    }
+    mealLog.discardRotated();
+    return true;
+}
+
+bool Database::openSnapshot() {
+    return snapshot.isOpen() || snapshot.open(snapshotFile);
+}
+
+std::string Database::serializeMeals() const {
+    std::stringstream ss;
+    for (const auto& meal : meals) {
+        ss << meal.toString() << "\n";
+    }
+    return ss.str();
+}
+
+void Database::rebuildUserIndexes() {
+    userIndex.clear();
+    usernameIndex.clear();
+    maxUserId = 0;
+    for (size_t i = 0; i < users.size(); ++i) {
+        userIndex.emplace(users[i].getId(), i);
+        // 用户名重复时保留第一条，与原先线性查找的行为一致
+        usernameIndex.emplace(users[i].getUsername(), i);
+        maxUserId = std::max(maxUserId, users[i].getId());
+    }
+}
+
+void Database::installFoods(std::vector<Food> foods) {
+    catalog = std::make_shared<const FoodCatalog>(std::move(foods));
+    FoodCatalog::publish(catalog);
+}
+
+void Database::rebuildMealIndexes() {
+    mealIndex.clear();
+    userTimelines.clear();
+    for (size_t i = 0; i < meals.size(); ++i) {
+        mealIndex.emplace(meals[i].getId(), i);
+        indexMeal(meals[i]);
+    }
+}
+
+void Database::reindexMealPositions(size_t from) {
+    for (size_t i = from; i < meals.size(); ++i) {
+        mealIndex[meals[i].getId()] = i;
+    }
+}
+
+void Database::reclaimMealSlots() {
+    if (freeMealSlots == 0) {
+        return;
+    }
+    auto first = std::find_if(meals.begin(), meals.end(), isFreeSlot);
+    size_t from = static_cast<size_t>(first - meals.begin());
+    meals.erase(std::remove_if(first, meals.end(), isFreeSlot), meals.end());
+    freeMealSlots = 0;
+    reindexMealPositions(from);
+}
+
+void Database::indexMeal(const Meal& meal) {
+    Timeline& timeline = userTimelines[meal.getUserId()];
+    TimelineEntry entry{meal.getDay().toDays(), meal.getId()};
+    // 新餐单通常是最近的日期，追加时只比较末尾
+    if (timeline.empty() || timeline.back() < entry) {
+        timeline.push_back(entry);
+    } else {
+        timeline.insert(std::lower_bound(timeline.begin(), timeline.end(), entry), entry);
+    }
+    nextMealId = std::max(nextMealId, meal.getId() + 1);
+}
+
+void Database::unindexMeal(const Meal& meal) {
+    auto userIt = userTimelines.find(meal.getUserId());
+    if (userIt == userTimelines.end()) {
+        return;
+    }
+    Timeline& timeline = userIt->second;
+    TimelineEntry entry{meal.getDay().toDays(), meal.getId()};
+    auto it = std::lower_bound(timeline.begin(), timeline.end(), entry);
+    if (it != timeline.end() && it->day == entry.day && it->mealId == entry.mealId) {
+        timeline.erase(it);
+    }
+    if (timeline.empty()) {
+        userTimelines.erase(userIt);
+    }
+}
+
+std::pair<Database::Timeline::const_iterator, Database::Timeline::const_iterator>
+Database::timelineRange(const Timeline& timeline, const Date& from, const Date& to) const {
+    auto begin = std::lower_bound(timeline.begin(), timeline.end(), from.toDays(),
+        [](const TimelineEntry& entry, int32_t day) { return entry.day < day; });
+    auto end = std::upper_bound(begin, timeline.end(), to.toDays(),
+        [](int32_t day, const TimelineEntry& entry) { return day < entry.day; });
+    return {begin, end};
+}
+
+std::vector<Meal> Database::collectMeals(Timeline::const_iterator begin, Timeline::const_iterator end) const {
+    std::vector<Meal> result;
+    result.reserve(static_cast<size_t>(end - begin));
+    for (auto it = begin; it != end; ++it) {
+        result.push_back(meals[mealIndex.at(it->mealId)]);
+    }
+    return result;
+}
+
+TagMask Database::parseTagString(std::string_view tagStr) const {
+    TagDictionary& dictionary = TagDictionary::instance();
+    TagMask tags;
+    size_t start = 0;
+    while (start < tagStr.size()) {
+        size_t end = tagStr.find(',', start);
+        if (end == std::string_view::npos) end = tagStr.size();
+        if (end > start) {
+            tags.set(dictionary.intern(tagStr.substr(start, end - start)));
+        }
+        start = end + 1;
     }
     return tags;
 }
 
 bool Database::loadFoods() {
-    std::ifstream file(foodsFile);
-    if (!file.is_open()) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::vector<Food> foods;
+    if (openSnapshot() && snapshot.isFresh(SnapshotFile::FoodsSection, foodsFile)) {
+        snapshot.decodeFoods(foods);
+        installFoods(std::move(foods));
+        return catalog->size() > 0;
+    }
+    snapshotStale = true;
+    
+    std::string buffer;
+    if (!TextParser::readFile(foodsFile, buffer)) {
         return false;
     }
     
-    foods.clear();
-    std::string line;
-    while (std::getline(file, line)) {
+    TextParser::LineReader reader(buffer);
+    std::vector<std::string_view> tokens;
+    std::string_view line;
+    while (reader.next(line)) {
         if (line.empty()) continue;
         
-        auto tokens = split(line, '|');
-        if (tokens.size() >= 9) {
+        if (TextParser::split(line, '|', tokens) >= 9) {
             try {
-                int id = std::stoi(tokens[0]);
-                std::string name = tokens[1];
-                double calories = std::stod(tokens[2]);
-                double protein = std::stod(tokens[3]);
-                double carbs = std::stod(tokens[4]);
-                double fat = std::stod(tokens[5]);
-                double fiber = std::stod(tokens[6]);
-                std::string tagsStr = tokens[7];
-                std::string category = tokens[8];
-                
-                auto tags = parseTagString(tagsStr);
+                int id = TextParser::toInt(tokens[0]);
+                double calories = TextParser::toDouble(tokens[2]);
+                double protein = TextParser::toDouble(tokens[3]);
+                double carbs = TextParser::toDouble(tokens[4]);
+                double fat = TextParser::toDouble(tokens[5]);
+                double fiber = TextParser::toDouble(tokens[6]);
                 
-                Food food(id, name, calories, protein, carbs, fat, fiber, tags, category);
-                foods.push_back(food);
+                foods.emplace_back(id, std::string(tokens[1]), calories, protein, carbs, fat, fiber,
+                                   parseTagString(tokens[7]), std::string(tokens[8]));
+            } catch (const std::length_error&) {
+                // 标签字典已满：跳过这一行会在下次保存时丢掉该食物，整体失败
+                throw;
             } catch (const std::exception& e) {
                 std::cout << "Error parsing food line: " << line << " - " << e.what() << std::endl;
             }
         }
     }
     
-    file.close();
-    return !foods.empty();
+    installFoods(std::move(foods));
+    return catalog->size() > 0;
 }
 
 bool Database::saveFoods() {
-    std::ofstream file(foodsFile);
-    if (!file.is_open()) {
-        return false;
-    }
-    
-    for (const auto& food : foods) {
-        file << food.toString() << std::endl;
+    foodsDirty = true;
+    return flushTables();
+}
+
+std::string Database::serializeFoods() const {
+    std::stringstream ss;
+    for (const auto& food : catalog->getFoods()) {
+        ss << food.toString() << "\n";
     }
-    
-    file.close();
-    return true;
+    return ss.str();
 }
 
 bool Database::loadUsers() {
-    std::ifstream file(usersFile);
-    if (!file.is_open()) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (openSnapshot() && snapshot.isFresh(SnapshotFile::UsersSection, usersFile)) {
+        snapshot.decodeUsers(users);
+        rebuildUserIndexes();
+        return true;
+    }
+    snapshotStale = true;
+    
+    std::string buffer;
+    if (!TextParser::readFile(usersFile, buffer)) {
         return false;
     }
     
     users.clear();
-    std::string line;
-    while (std::getline(file, line)) {
+    TextParser::LineReader reader(buffer);
+    std::vector<std::string_view> tokens;
+    std::string_view line;
+    while (reader.next(line)) {
         if (line.empty()) continue;
         
-        auto tokens = split(line, '|');
-        if (tokens.size() >= 12) {
+        if (TextParser::split(line, '|', tokens) >= 12) {
             try {
-                int id = std::stoi(tokens[0]);
-                std::string username = tokens[1];
-                std::string password = tokens[2];
-                int age = std::stoi(tokens[3]);
-                double weight = std::stod(tokens[4]);
-                double height = std::stod(tokens[5]);
-                std::string gender = tokens[6];
-                std::string activityLevel = tokens[7];
-                double dailyCalorieGoal = std::stod(tokens[8]);
-                double dailyProteinGoal = std::stod(tokens[9]);
-                double dailyCarbGoal = std::stod(tokens[10]);
-                double dailyFatGoal = std::stod(tokens[11]);
+                int id = TextParser::toInt(tokens[0]);
+                int age = TextParser::toInt(tokens[3]);
+                double weight = TextParser::toDouble(tokens[4]);
+                double height = TextParser::toDouble(tokens[5]);
+                double dailyCalorieGoal = TextParser::toDouble(tokens[8]);
+                double dailyProteinGoal = TextParser::toDouble(tokens[9]);
+                double dailyCarbGoal = TextParser::toDouble(tokens[10]);
+                double dailyFatGoal = TextParser::toDouble(tokens[11]);
                 
-                std::set<std::string> preferredTags;
-                std::set<std::string> avoidedTags;
-                std::set<std::string> allergens;
+                TagMask preferredTags;
+                TagMask avoidedTags;
+                TagMask allergens;
                 
                 if (tokens.size() > 12) {
                     preferredTags = parseTagString(tokens[12]);
@@ -128,48 +500,63 @@ bool Database::loadUsers() {
                     allergens = parseTagString(tokens[14]);
                 }
                 
-                User user(id, username, password);
+                User user(id, std::string(tokens[1]), std::string(tokens[2]));
                 user.setAge(age);
                 user.setWeight(weight);
                 user.setHeight(height);
-                user.setGender(gender);
-                user.setActivityLevel(activityLevel);
+                user.setGender(std::string(tokens[6]));
+                user.setActivityLevel(std::string(tokens[7]));
                 user.setDailyCalorieGoal(dailyCalorieGoal);
                 user.setDailyProteinGoal(dailyProteinGoal);
                 user.setDailyCarbGoal(dailyCarbGoal);
                 user.setDailyFatGoal(dailyFatGoal);
                 
-                for (const auto& tag : preferredTags) {
-                    user.addPreferredTag(tag);
-                }
-                for (const auto& tag : avoidedTags) {
-                    user.addAvoidedTag(tag);
-                }
-                for (const auto& allergen : allergens) {
-                    user.addAllergen(allergen);
-                }
+                user.setPreferredTagMask(preferredTags);
+                user.setAvoidedTagMask(avoidedTags);
+                user.setAllergenMask(allergens);
                 
                 users.push_back(user);
+            } catch (const std::length_error&) {
+                // 标签字典已满：跳过这一行会在下次保存时丢掉该用户，整体失败
+                throw;
             } catch (const std::exception& e) {
                 std::cout << "Error parsing user line: " << line << " - " << e.what() << std::endl;
             }
         }
     }
     
-    file.close();
+    rebuildUserIndexes();
     return true;
 }
 
 bool Database::saveUser(const User& user) {
-    for (size_t i = 0; i < users.size(); ++i) {
-        if (users[i].getId() == user.getId()) {
-            users[i] = user;
-            return saveUsers();
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = userIndex.find(user.getId());
+        if (it != userIndex.end()) {
+            size_t pos = it->second;
+            const std::string oldName = users[pos].getUsername();
+            users[pos] = user;
+            if (oldName != user.getUsername()) {
+                auto nameIt = usernameIndex.find(oldName);
+                if (nameIt != usernameIndex.end() && nameIt->second == pos) {
+                    usernameIndex.erase(nameIt);
+                }
+                usernameIndex.emplace(user.getUsername(), pos);
+            }
+        } else {
+            users.push_back(user);
+            userIndex[user.getId()] = users.size() - 1;
+            usernameIndex.emplace(user.getUsername(), users.size() - 1);
+            maxUserId = std::max(maxUserId, user.getId());
         }
+        usersDirty = true;
     }
     
-    users.push_back(user);
-    return saveUsers();
+    if (deferPersist()) {
+        return true;
+    }
+    return flushTables();
 }
 
 bool Database::updateUser(const User& user) {
@@ -177,235 +564,505 @@ bool Database::updateUser(const User& user) {
 }
 
 bool Database::saveUsers() {
-    std::ofstream file(usersFile);
-    if (!file.is_open()) {
-        return false;
+    usersDirty = true;
+    return flushTables();
+}
+
+std::string Database::serializeUsers() const {
+    std::stringstream ss;
+    for (const auto& user : users) {
+        ss << user.toString() << "\n";
     }
+    return ss.str();
+}
+
+Meal Database::parseMealFields(const std::vector<std::string_view>& tokens) const {
+    int id = TextParser::toInt(tokens[0]);
+    if (id <= 0) {
+        // ID 0 表示已删除的空槽
+        throw std::invalid_argument("invalid meal id: " + std::string(tokens[0]));
+    }
+    int userId = TextParser::toInt(tokens[1]);
+    (void)TextParser::toDouble(tokens[4]);  // totalCalories - recalculated from foods
+    (void)TextParser::toDouble(tokens[5]);  // totalProtein - recalculated from foods
+    (void)TextParser::toDouble(tokens[6]);  // totalCarbs - recalculated from foods
+    (void)TextParser::toDouble(tokens[7]);  // totalFat - recalculated from foods
+    bool isRecommended = (tokens[8] == "1");
     
-    for (const auto& user : users) {
-        file << user.toString() << std::endl;
+    auto date = Date::parse(tokens[2]);
+    if (!date) {
+        throw std::invalid_argument("invalid date: " + std::string(tokens[2]));
     }
+    Meal meal(id, userId, *date, std::string(tokens[3]));
+    meal.setIsRecommended(isRecommended);
     
-    file.close();
-    return true;
+    std::string_view foodIds = tokens[9];
+    size_t start = 0;
+    while (start < foodIds.size()) {
+        size_t end = foodIds.find(',', start);
+        if (end == std::string_view::npos) end = foodIds.size();
+        if (end > start) {
+            // "食物ID" 或 "食物ID*份数"
+            std::string_view item = foodIds.substr(start, end - start);
+            size_t star = item.find('*');
+            int foodId = TextParser::toInt(item.substr(0, star));
+            double portion = star == std::string_view::npos ? 1.0 : TextParser::toDouble(item.substr(star + 1));
+            if (const Food* food = catalog->find(foodId)) {
+                meal.addFood(*food, portion);
+            }
+        }
+        start = end + 1;
+    }
+    return meal;
 }
 
-bool Database::loadMeals() {
-    std::ifstream file(mealsFile);
-    if (!file.is_open()) {
-        return false;
+Meal Database::parseMealLine(std::string_view line) const {
+    std::vector<std::string_view> tokens;
+    if (TextParser::split(line, '|', tokens) < 10) {
+        throw std::invalid_argument("expected 10 fields");
     }
-    
-    meals.clear();
-    std::string line;
-    while (std::getline(file, line)) {
+    return parseMealFields(tokens);
+}
+
+Database::MealChunk Database::parseMealChunk(std::string_view chunk) const {
+    MealChunk result;
+    TextParser::LineReader reader(chunk);
+    std::vector<std::string_view> tokens;
+    std::string_view line;
+    while (reader.next(line)) {
         if (line.empty()) continue;
         
-        auto tokens = split(line, '|');
-        if (tokens.size() >= 10) {
+        if (TextParser::split(line, '|', tokens) >= 10) {
             try {
-                int id = std::stoi(tokens[0]);
-                int userId = std::stoi(tokens[1]);
-                std::string date = tokens[2];
-                std::string mealType = tokens[3];
-                (void)std::stod(tokens[4]);  // totalCalories - recalculated from foods
-                (void)std::stod(tokens[5]);  // totalProtein - recalculated from foods
-                (void)std::stod(tokens[6]);  // totalCarbs - recalculated from foods
-                (void)std::stod(tokens[7]);  // totalFat - recalculated from foods
-                bool isRecommended = (tokens[8] == "1");
-                
-                Meal meal(id, userId, date, mealType);
-                meal.setIsRecommended(isRecommended);
-                
-                if (tokens.size() > 9) {
-                    auto foodIds = split(tokens[9], ',');
-                    for (const auto& foodIdStr : foodIds) {
-                        if (!foodIdStr.empty()) {
-                            int foodId = std::stoi(foodIdStr);
-                            auto food = getFoodById(foodId);
-                            if (food) {
-                                meal.addFood(*food);
-                            }
-                        }
-                    }
-                }
-                
-                meals.push_back(meal);
+                result.meals.push_back(parseMealFields(tokens));
             } catch (const std::exception& e) {
-                std::cout << "Error parsing meal line: " << line << " - " << e.what() << std::endl;
+                result.errors.push_back("Error parsing meal line: " + std::string(line) + " - " + e.what());
             }
         }
     }
+    return result;
+}
+
+void Database::parseMealBuffer(std::string_view buffer) {
+    // 每行在 foods 加载完成后相互独立：按换行对齐切块，在线程池上并行解析，
+    // 再按块顺序合并，结果与顺序解析完全相同（即文件中的ID顺序）
+    std::vector<std::string_view> chunks;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    if (buffer.size() >= kMinParallelParseBytes && threads > 1) {
+        size_t chunkCount = threads * 4;
+        size_t chunkSize = std::max(kMinParallelParseBytes / 4, buffer.size() / chunkCount + 1);
+        size_t start = 0;
+        while (start < buffer.size()) {
+            size_t end = std::min(buffer.size(), start + chunkSize);
+            if (end < buffer.size()) {
+                size_t newline = buffer.find('\n', end);
+                end = newline == std::string_view::npos ? buffer.size() : newline + 1;
+            }
+            chunks.push_back(buffer.substr(start, end - start));
+            start = end;
+        }
+    } else {
+        chunks.push_back(buffer);
+    }
     
-    file.close();
-    return true;
+    std::vector<MealChunk> results;
+    if (chunks.size() == 1) {
+        results.push_back(parseMealChunk(chunks.front()));
+    } else {
+        ThreadPool pool(threads);
+        std::vector<std::future<MealChunk>> pending;
+        pending.reserve(chunks.size());
+        for (auto chunk : chunks) {
+            pending.push_back(pool.submit([this, chunk]() { return parseMealChunk(chunk); }));
+        }
+        for (auto& future : pending) {
+            results.push_back(future.get());
+        }
+    }
+    
+    size_t total = meals.size();
+    for (const auto& result : results) total += result.meals.size();
+    meals.reserve(total);
+    for (auto& result : results) {
+        for (const auto& error : result.errors) {
+            std::cout << error << std::endl;
+        }
+        std::move(result.meals.begin(), result.meals.end(), std::back_inserter(meals));
+    }
 }
 
-bool Database::saveMeal(const Meal& meal) {
-    for (size_t i = 0; i < meals.size(); ++i) {
-        if (meals[i].getId() == meal.getId()) {
-            meals[i] = meal;
-            return saveMeals();
+bool Database::loadMeals() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    meals.clear();
+    freeMealSlots = 0;
+    
+    bool hasSnapshot = false;
+    std::string buffer;
+    if (openSnapshot() && snapshot.isFresh(SnapshotFile::MealsSection, mealsFile)) {
+        snapshot.decodeMeals(meals, [this](int foodId) -> const Food* {
+            return catalog->find(foodId);
+        });
+        hasSnapshot = true;
+    } else {
+        snapshotStale = true;
+        hasSnapshot = TextParser::readFile(mealsFile, buffer);
+    }
+    snapshot.close();
+    
+    parseMealBuffer(buffer);
+    rebuildMealIndexes();
+    
+    // 在快照之上重放变更日志；插入和更新都按 upsert 处理，重放是幂等的
+    mealLog.close();
+    bool hasLog = mealLog.replay([this](char op, const std::string& payload) {
+        try {
+            if (op == 'D') {
+                applyMealDelete(TextParser::toInt(payload));
+            } else {
+                applyMealUpsert(parseMealLine(payload));
+            }
+        } catch (const std::exception& e) {
+            std::cout << "Error parsing meal log line: " << payload << " - " << e.what() << std::endl;
         }
+    });
+    mealLog.open();
+    reclaimMealSlots();
+    
+    bool refreshSnapshot = snapshotStale;
+    snapshotStale = false;
+    lock.unlock();
+    startCompactor();
+    if (refreshSnapshot) {
+        // 本次有分区走了文本导入，后台重新生成二进制快照，下次启动直接映射
+        {
+            std::lock_guard<std::mutex> compactorLock(compactorMutex);
+            compactRequested = true;
+        }
+        compactorCv.notify_one();
+    }
+    return hasSnapshot || hasLog;
+}
+
+void Database::applyMealUpsert(const Meal& meal) {
+    auto it = mealIndex.find(meal.getId());
+    if (it != mealIndex.end()) {
+        unindexMeal(meals[it->second]);
+        meals[it->second] = meal;
+        indexMeal(meal);
+        return;
     }
     
     meals.push_back(meal);
-    return saveMeals();
+    mealIndex[meal.getId()] = meals.size() - 1;
+    indexMeal(meal);
 }
 
-bool Database::updateMeal(const Meal& meal) {
-    for (size_t i = 0; i < meals.size(); ++i) {
-        if (meals[i].getId() == meal.getId()) {
-            meals[i] = meal;
-            return saveMeals();
-        }
+bool Database::applyMealDelete(int mealId) {
+    auto it = mealIndex.find(mealId);
+    if (it == mealIndex.end()) {
+        return false;
     }
-    return false;
+    
+    size_t pos = it->second;
+    unindexMeal(meals[pos]);
+    mealIndex.erase(it);
+    meals[pos] = Meal();
+    ++freeMealSlots;
+    return true;
 }
 
-bool Database::deleteMeal(int mealId) {
-    for (size_t i = 0; i < meals.size(); ++i) {
-        if (meals[i].getId() == mealId) {
-            meals.erase(meals.begin() + i);
-            return saveMeals();
-        }
+std::vector<int> Database::applyMealDeleteDay(const Date& date, int userId) {
+    auto userIt = userTimelines.find(userId);
+    if (userIt == userTimelines.end()) {
+        return {};
     }
-    return false;
+    auto range = timelineRange(userIt->second, date, date);
+    // 删除会修改时间线，先取出区间内的ID
+    std::vector<int> deletedIds;
+    for (auto it = range.first; it != range.second; ++it) {
+        deletedIds.push_back(it->mealId);
+    }
+    for (int id : deletedIds) {
+        applyMealDelete(id);
+    }
+    return deletedIds;
 }
 
-int Database::deleteMealsByDateAndUser(const std::string& date, int userId) {
-    int deletedCount = 0;
-    for (auto it = meals.begin(); it != meals.end();) {
-        if (it->getDate() == date && it->getUserId() == userId) {
-            it = meals.erase(it);
-            ++deletedCount;
-        } else {
-            ++it;
+MealBatchResult Database::commitMealBatch(const MealBatch& batch) {
+    MealBatchResult result{true, 0, {}};
+    MealLog::Ticket ticket;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        std::vector<std::string> records;
+        for (const auto& op : batch.getOps()) {
+            switch (op.type) {
+            case MealBatch::OpType::Insert: {
+                Meal meal = op.meal;
+                if (meal.getId() <= 0) {
+                    meal.setId(nextMealId);
+                }
+                bool exists = mealIndex.find(meal.getId()) != mealIndex.end();
+                applyMealUpsert(meal);
+                records.push_back(exists ? MealLog::updateRecord(meal) : MealLog::insertRecord(meal));
+                result.inserted.push_back(meal);
+                break;
+            }
+            case MealBatch::OpType::Delete:
+                if (applyMealDelete(op.mealId)) {
+                    records.push_back(MealLog::deleteRecord(op.mealId));
+                    ++result.deletedCount;
+                }
+                break;
+            case MealBatch::OpType::DeleteDay:
+                for (int id : applyMealDeleteDay(op.date, op.userId)) {
+                    records.push_back(MealLog::deleteRecord(id));
+                    ++result.deletedCount;
+                }
+                break;
+            }
         }
+        if (records.empty()) {
+            return result;
+        }
+        // 在持锁期间排队，保证日志顺序与内存中的应用顺序一致
+        ticket = mealLog.enqueue(records);
+        notifyCompactorIfNeeded();
     }
-
-    if (deletedCount == 0) {
-        return 0;
+    
+    // 异步策略下由后台线程统一 fsync；同步策略在锁外等待落盘，
+    // 并发请求的批次在这里合并为一次 fsync
+    if (deferPersist()) {
+        return result;
     }
+    result.success = mealLog.wait(ticket);
+    return result;
+}
 
-    return saveMeals() ? deletedCount : -1;
+bool Database::saveMeal(const Meal& meal) {
+    MealBatch batch;
+    batch.insert(meal);
+    return commitMealBatch(batch).success;
 }
 
-bool Database::saveMeals() {
-    std::ofstream file(mealsFile);
-    if (!file.is_open()) {
-        return false;
+bool Database::updateMeal(const Meal& meal) {
+    MealLog::Ticket ticket;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (mealIndex.find(meal.getId()) == mealIndex.end()) {
+            return false;
+        }
+        applyMealUpsert(meal);
+        ticket = mealLog.enqueue({MealLog::updateRecord(meal)});
+        notifyCompactorIfNeeded();
     }
-    
-    for (const auto& meal : meals) {
-        file << meal.toString() << std::endl;
+    if (deferPersist()) {
+        return true;
     }
-    
-    file.close();
-    return true;
+    return mealLog.wait(ticket);
+}
+
+bool Database::deleteMeal(int mealId) {
+    MealBatch batch;
+    batch.remove(mealId);
+    MealBatchResult result = commitMealBatch(batch);
+    return result.success && result.deletedCount > 0;
+}
+
+int Database::deleteMealsByDateAndUser(const Date& date, int userId) {
+    MealBatch batch;
+    batch.removeDay(date, userId);
+    MealBatchResult result = commitMealBatch(batch);
+    return result.success ? result.deletedCount : -1;
+}
+
+bool Database::saveMeals() {
+    // 整体写出快照并清空日志，等价于一次同步压缩
+    return compactMeals();
 }
 
 std::vector<Food> Database::getAllFoods() const {
-    return foods;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return catalog->getFoods();
+}
+
+std::shared_ptr<const FoodCatalog> Database::getFoodCatalog() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return catalog;
 }
 
 std::vector<User> Database::getAllUsers() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
     return users;
 }
 
 std::vector<Meal> Database::getAllMeals() const {
-    return meals;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<Meal> result;
+    result.reserve(meals.size() - freeMealSlots);
+    std::copy_if(meals.begin(), meals.end(), std::back_inserter(result),
+                 [](const Meal& meal) { return !isFreeSlot(meal); });
+    return result;
 }
 
-std::vector<Meal> Database::getMealsByUser(int userId) const {
-    std::vector<Meal> result;
-    for (const auto& meal : meals) {
-        if (meal.getUserId() == userId) {
-            result.push_back(meal);
-        }
+void Database::forEachUser(const std::function<void(const User&)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& user : users) {
+        visit(user);
     }
-    return result;
 }
 
-std::vector<Meal> Database::getMealsByDate(const std::string& date) const {
-    std::vector<Meal> result;
+void Database::forEachMeal(const std::function<void(const Meal&)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
     for (const auto& meal : meals) {
-        if (meal.getDate() == date) {
-            result.push_back(meal);
+        if (!isFreeSlot(meal)) {
+            visit(meal);
         }
     }
-    return result;
 }
 
-std::vector<Meal> Database::getMealsByDateAndUser(const std::string& date, int userId) const {
+void Database::forEachMealOfUser(int userId, const std::function<void(const Meal&)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = userTimelines.find(userId);
+    if (it == userTimelines.end()) {
+        return;
+    }
+    for (const auto& entry : it->second) {
+        visit(meals[mealIndex.at(entry.mealId)]);
+    }
+}
+
+void Database::forEachMealOfUserInRange(int userId, const Date& from, const Date& to,
+                                        const std::function<void(const Meal&)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = userTimelines.find(userId);
+    if (it == userTimelines.end()) {
+        return;
+    }
+    auto range = timelineRange(it->second, from, to);
+    for (auto entry = range.first; entry != range.second; ++entry) {
+        visit(meals[mealIndex.at(entry->mealId)]);
+    }
+}
+
+std::vector<Meal> Database::getMealsByUser(int userId) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = userTimelines.find(userId);
+    if (it == userTimelines.end()) {
+        return {};
+    }
+    return collectMeals(it->second.begin(), it->second.end());
+}
+
+std::vector<Meal> Database::getMealsByDate(const Date& date) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
     std::vector<Meal> result;
-    for (const auto& meal : meals) {
-        if (meal.getDate() == date && meal.getUserId() == userId) {
-            result.push_back(meal);
+    for (const auto& entry : userTimelines) {
+        auto range = timelineRange(entry.second, date, date);
+        for (auto it = range.first; it != range.second; ++it) {
+            result.push_back(meals[mealIndex.at(it->mealId)]);
         }
     }
     return result;
 }
 
+std::vector<Meal> Database::getMealsByDateAndUser(const Date& date, int userId) const {
+    return getMealsByUserInRange(userId, date, date);
+}
+
+std::vector<Meal> Database::getMealsByUserInRange(int userId, const Date& from, const Date& to) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = userTimelines.find(userId);
+    if (it == userTimelines.end()) {
+        return {};
+    }
+    auto range = timelineRange(it->second, from, to);
+    return collectMeals(range.first, range.second);
+}
+
+MealPage Database::getMealPageByUser(int userId, const Date& from, const Date& to, size_t limit,
+                                     const std::optional<MealCursor>& before) const {
+    MealPage page{{}, false, {}};
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = userTimelines.find(userId);
+    if (it == userTimelines.end()) {
+        return page;
+    }
+    auto range = timelineRange(it->second, from, to);
+    auto end = range.second;
+    if (before) {
+        TimelineEntry cursor{before->date.toDays(), before->mealId};
+        end = std::lower_bound(range.first, end, cursor);
+    }
+
+    // 从区间末尾（最新）向前取，最多 limit 条
+    size_t available = static_cast<size_t>(end - range.first);
+    size_t count = limit == 0 ? available : std::min(limit, available);
+    page.meals.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        page.meals.push_back(meals[mealIndex.at((end - 1 - i)->mealId)]);
+    }
+    if (count < available) {
+        page.hasMore = true;
+        auto last = end - count;
+        page.next = {Date::fromDays(last->day), last->mealId};
+    }
+    return page;
+}
+
 std::optional<Meal> Database::getMealById(int id) const {
-    for (const auto& meal : meals) {
-        if (meal.getId() == id) {
-            return meal;
-        }
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = mealIndex.find(id);
+    if (it == mealIndex.end()) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return meals[it->second];
 }
 
 std::optional<Food> Database::getFoodById(int id) const {
-    for (const auto& food : foods) {
-        if (food.getId() == id) {
-            return food;
-        }
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const Food* food = catalog->find(id);
+    if (!food) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return *food;
 }
 
 std::optional<User> Database::getUserById(int id) const {
-    for (const auto& user : users) {
-        if (user.getId() == id) {
-            return user;
-        }
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = userIndex.find(id);
+    if (it == userIndex.end()) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return users[it->second];
 }
 
-int Database::getNextFoodId() const {
-    int maxId = 0;
-    for (const auto& food : foods) {
-        if (food.getId() > maxId) {
-            maxId = food.getId();
-        }
+std::optional<User> Database::getUserByUsername(const std::string& username) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = usernameIndex.find(username);
+    if (it == usernameIndex.end()) {
+        return std::nullopt;
     }
-    return maxId + 1;
+    return users[it->second];
+}
+
+int Database::getNextFoodId() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return catalog->getMaxId() + 1;
 }
 
 int Database::getNextUserId() const {
-    int maxId = 0;
-    for (const auto& user : users) {
-        if (user.getId() > maxId) {
-            maxId = user.getId();
-        }
-    }
-    return maxId + 1;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return maxUserId + 1;
 }
 
 int Database::getNextMealId() const {
-    int maxId = 0;
-    for (const auto& meal : meals) {
-        if (meal.getId() > maxId) {
-            maxId = meal.getId();
-        }
-    }
-    return maxId + 1;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return nextMealId;
 }
 
 void Database::initializeSampleData() {
-    foods.clear();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::vector<Food> foods;
     
     foods.push_back(Food(1, u8"白米饭", 116, 2.6, 25.6, 0.3, 0.3, {u8"清淡"}, u8"主食"));
     foods.push_back(Food(2, u8"全麦面包", 246, 8.5, 45.3, 3.5, 6.8, {u8"清淡"}, u8"主食"));
@@ -473,5 +1130,8 @@ void Database::initializeSampleData() {
     foods.push_back(Food(49, u8"鹌鹑蛋", 158, 13.1, 0.6, 11.6, 0.0, {u8"清淡"}, u8"蛋类"));
     foods.push_back(Food(50, u8"松花蛋", 171, 13.7, 4.9, 10.7, 0.0, {u8"咸"}, u8"蛋类"));
     
-    saveFoods();
+    installFoods(std::move(foods));
+    foodsDirty = true;
+    lock.unlock();
+    flushTables();
 }
@@ -0,0 +1,92 @@
+#include "../include/Date.h"
+
+namespace {
+// 公历与天数互转，算法见 Howard Hinnant 的 days_from_civil / civil_from_days
+int32_t daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = year - era * 400;
+    const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void civilFromDays(int32_t days, int& year, int& month, int& day) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const int doe = days - era * 146097;
+    const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2);
+}
+
+bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int daysInMonth(int year, int month) {
+    static const int kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeapYear(year) ? 29 : kDays[month - 1];
+}
+
+bool readDigits(std::string_view str, size_t pos, size_t count, int& value) {
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (str[i] < '0' || str[i] > '9') return false;
+        value = value * 10 + (str[i] - '0');
+    }
+    return true;
+}
+}
+
+Date Date::fromYmd(int year, int month, int day) {
+    if (year < 1 || year > 9999 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+        return Date();
+    }
+    return Date(daysFromCivil(year, month, day));
+}
+
+Date Date::earliest() {
+    return fromYmd(1, 1, 1);
+}
+
+Date Date::latest() {
+    return fromYmd(9999, 12, 31);
+}
+
+std::optional<Date> Date::parse(std::string_view str) {
+    if (str.size() != 10 || str[4] != '-' || str[7] != '-') {
+        return std::nullopt;
+    }
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (!readDigits(str, 0, 4, year) || !readDigits(str, 5, 2, month) || !readDigits(str, 8, 2, day)) {
+        return std::nullopt;
+    }
+    Date date = fromYmd(year, month, day);
+    if (!date.isValid()) {
+        return std::nullopt;
+    }
+    return date;
+}
+
+std::string Date::toString() const {
+    if (!isValid()) {
+        return "";
+    }
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    civilFromDays(days, year, month, day);
+    std::string result = "0000-00-00";
+    for (int i = 3; i >= 0; --i, year /= 10) result[i] = static_cast<char>('0' + year % 10);
+    result[5] = static_cast<char>('0' + month / 10);
+    result[6] = static_cast<char>('0' + month % 10);
+    result[8] = static_cast<char>('0' + day / 10);
+    result[9] = static_cast<char>('0' + day % 10);
+    return result;
+}
@@ -9,16 +9,24 @@ Food::Food() : id(0), name(""), calories(0), protein(0),
 Food::Food(int id, const std::string& name, double cal, double prot, 
            double carb, double fat, double fiber, 
            const std::set<std::string>& tags, const std::string& category)
+    : id(id), name(name), calories(cal), protein(prot), 
+      carbohydrates(carb), fat(fat), fiber(fiber), 
+      tags(TagDictionary::instance().toMask(tags)), category(category) {}
+
+Food::Food(int id, const std::string& name, double cal, double prot, 
+           double carb, double fat, double fiber, 
+           const TagMask& tags, const std::string& category)
     : id(id), name(name), calories(cal), protein(prot), 
       carbohydrates(carb), fat(fat), fiber(fiber), 
       tags(tags), category(category) {}
 
 void Food::addTag(const std::string& tag) {
-    tags.insert(tag);
+    tags.set(TagDictionary::instance().intern(tag));
 }
 
 bool Food::hasTag(const std::string& tag) const {
-    return tags.find(tag) != tags.end();
+    int tagId = TagDictionary::instance().find(tag);
+    return tagId >= 0 && tags.test(tagId);
 }
 
 void Food::displayInfo() const {
@@ -37,7 +45,7 @@ void Food::displayInfo() const {
      if (!tags.empty()) {
          std::cout << u8"  口味标签: ";
          bool first = true;
-         for (const auto& tag : tags) {
+         for (const auto& tag : TagDictionary::instance().toNames(tags)) {
              if (!first) std::cout << u8", ";
              std::cout << tag;
              first = false;
@@ -53,7 +61,7 @@ std::string Food::toString() const {
        << carbohydrates << "|" << fat << "|" << fiber << "|";
     
     bool first = true;
-    for (const auto& tag : tags) {
+    for (const auto& tag : TagDictionary::instance().toNames(tags)) {
         if (!first) ss << ",";
         ss << tag;
         first = false;
@@ -0,0 +1,88 @@
+#include "../include/FoodCatalog.h"
+#include <atomic>
+#include <algorithm>
+
+namespace {
+std::atomic<uint64_t> nextVersion(1);
+
+std::shared_ptr<const FoodCatalog>& currentCatalog() {
+    static std::shared_ptr<const FoodCatalog> catalog = std::make_shared<const FoodCatalog>(std::vector<Food>());
+    return catalog;
+}
+}
+
+FoodCatalog::FoodCatalog(std::vector<Food> foods)
+    : foods(std::move(foods)), maxId(0), version(nextVersion.fetch_add(1)) {
+    const size_t count = this->foods.size();
+    index.reserve(count);
+    ids.reserve(count);
+    calories.reserve(count);
+    protein.reserve(count);
+    carbohydrates.reserve(count);
+    fat.reserve(count);
+    fiber.reserve(count);
+    categoryIds.reserve(count);
+
+    // 标签列每行只保存目录中用到的前几个字，字典里的标签不多时每行只占 8 字节
+    tagStride = 1;
+    for (const Food& food : this->foods) {
+        for (int w = TagMask::kWords; w > tagStride; --w) {
+            if (food.getTagMask().bits[w - 1] != 0) {
+                tagStride = w;
+                break;
+            }
+        }
+    }
+    tagWords.reserve(count * static_cast<size_t>(tagStride));
+
+    std::unordered_map<std::string, int> categoryIndex;
+    for (size_t i = 0; i < count; ++i) {
+        const Food& food = this->foods[i];
+        index.emplace(food.getId(), i);
+        maxId = std::max(maxId, food.getId());
+
+        auto category = categoryIndex.emplace(food.getCategory(), static_cast<int>(categories.size()));
+        if (category.second) {
+            categories.push_back(food.getCategory());
+        }
+
+        ids.push_back(food.getId());
+        calories.push_back(food.getCalories());
+        protein.push_back(food.getProtein());
+        carbohydrates.push_back(food.getCarbohydrates());
+        fat.push_back(food.getFat());
+        fiber.push_back(food.getFiber());
+        categoryIds.push_back(category.first->second);
+        const TagMask& tags = food.getTagMask();
+        tagWords.insert(tagWords.end(), tags.bits, tags.bits + tagStride);
+    }
+}
+
+const Food* FoodCatalog::find(int id) const {
+    auto it = index.find(id);
+    return it == index.end() ? nullptr : &foods[it->second];
+}
+
+int FoodCatalog::indexOf(int id) const {
+    auto it = index.find(id);
+    return it == index.end() ? -1 : static_cast<int>(it->second);
+}
+
+int FoodCatalog::findCategory(const std::string& category) const {
+    for (size_t i = 0; i < categories.size(); ++i) {
+        if (categories[i] == category) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::shared_ptr<const FoodCatalog> FoodCatalog::current() {
+    return std::atomic_load(&currentCatalog());
+}
+
+void FoodCatalog::publish(std::shared_ptr<const FoodCatalog> catalog) {
+    if (catalog) {
+        std::atomic_store(&currentCatalog(), std::move(catalog));
+    }
+}
@@ -1,47 +1,75 @@
 #include "../include/Meal.h"
+#include "../include/FoodCatalog.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 
-Meal::Meal() : id(0), userId(0), date(""), mealType(""), 
+Meal::Meal() : id(0), userId(0), mealType(""), 
                totalCalories(0), totalProtein(0), totalCarbs(0), 
                totalFat(0), isRecommended(false) {}
 
 Meal::Meal(int id, int userId, const std::string& date, const std::string& mealType)
+    : id(id), userId(userId), date(Date::parse(date).value_or(Date())), mealType(mealType),
+      totalCalories(0), totalProtein(0), totalCarbs(0), 
+      totalFat(0), isRecommended(false) {}
+
+Meal::Meal(int id, int userId, const Date& date, const std::string& mealType)
     : id(id), userId(userId), date(date), mealType(mealType),
       totalCalories(0), totalProtein(0), totalCarbs(0), 
       totalFat(0), isRecommended(false) {}
 
-void Meal::addFood(const Food& food) {
-    foods.push_back(food);
-    calculateTotals();
+void Meal::addFood(const Food& food, double portion) {
+    foodIds.push_back(food.getId());
+    portions.push_back(portion);
+    totalCalories += food.getCalories() * portion;
+    totalProtein += food.getProtein() * portion;
+    totalCarbs += food.getCarbohydrates() * portion;
+    totalFat += food.getFat() * portion;
 }
 
-void Meal::removeFood(int foodId) {
-    foods.erase(
-        std::remove_if(foods.begin(), foods.end(),
-            [foodId](const Food& f) { return f.getId() == foodId; }),
-        foods.end()
-    );
-    calculateTotals();
+void Meal::removeFood(int foodId, const FoodCatalog& catalog) {
+    size_t kept = 0;
+    for (size_t i = 0; i < foodIds.size(); ++i) {
+        if (foodIds[i] != foodId) {
+            foodIds[kept] = foodIds[i];
+            portions[kept] = portions[i];
+            ++kept;
+        }
+    }
+    foodIds.resize(kept);
+    portions.resize(kept);
+    calculateTotals(catalog);
 }
 
-void Meal::calculateTotals() {
+void Meal::calculateTotals(const FoodCatalog& catalog) {
     totalCalories = 0;
     totalProtein = 0;
     totalCarbs = 0;
     totalFat = 0;
     
-    for (const auto& food : foods) {
-        totalCalories += food.getCalories();
-        totalProtein += food.getProtein();
-        totalCarbs += food.getCarbohydrates();
-        totalFat += food.getFat();
+    for (size_t i = 0; i < foodIds.size(); ++i) {
+        const Food* food = catalog.find(foodIds[i]);
+        if (!food) continue;
+        totalCalories += food->getCalories() * portions[i];
+        totalProtein += food->getProtein() * portions[i];
+        totalCarbs += food->getCarbohydrates() * portions[i];
+        totalFat += food->getFat() * portions[i];
+    }
+}
+
+std::vector<Food> Meal::getFoods(const FoodCatalog& catalog) const {
+    std::vector<Food> foods;
+    foods.reserve(foodIds.size());
+    for (int foodId : foodIds) {
+        if (const Food* food = catalog.find(foodId)) {
+            foods.push_back(*food);
+        }
     }
+    return foods;
 }
 
-void Meal::displayMeal() const {
+void Meal::displayMeal(const FoodCatalog& catalog) const {
      std::string mealTypeCN;
      if (mealType == "breakfast") mealTypeCN = u8"早餐";
      else if (mealType == "lunch") mealTypeCN = u8"午餐";
@@ -50,11 +78,12 @@ void Meal::displayMeal() const {
      else mealTypeCN = mealType;
 
      std::cout << "\n========================================" << std::endl;
-     std::cout << mealTypeCN << u8" - " << date;
+     std::cout << mealTypeCN << u8" - " << date.toString();
      if (isRecommended) std::cout << u8" [系统推荐]";
      std::cout << std::endl;
      std::cout << "========================================" << std::endl;
 
+     const auto foods = getFoods(catalog);
      if (foods.empty()) {
          std::cout << u8"  (暂无食物)                       " << std::endl;
      } else {
@@ -79,15 +108,15 @@ void Meal::displayMeal() const {
 
 std::string Meal::toString() const {
     std::stringstream ss;
-    ss << id << "|" << userId << "|" << date << "|" << mealType << "|"
+    ss << id << "|" << userId << "|" << date.toString() << "|" << mealType << "|"
        << totalCalories << "|" << totalProtein << "|" << totalCarbs << "|" 
        << totalFat << "|" << (isRecommended ? "1" : "0") << "|";
     
-    bool first = true;
-    for (const auto& food : foods) {
-        if (!first) ss << ",";
-        ss << food.getId();
-        first = false;
+    // 份数不为 1 时写作 "食物ID*份数"
+    for (size_t i = 0; i < foodIds.size(); ++i) {
+        if (i > 0) ss << ",";
+        ss << foodIds[i];
+        if (portions[i] != 1.0) ss << "*" << portions[i];
     }
     
     return ss.str();
@@ -0,0 +1,304 @@
+#include "../include/MealLog.h"
+#include "../include/TextParser.h"
+#include "../include/FileSync.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <algorithm>
+
+MealLog::MealLog() : out(nullptr), recordCount(0),
+                     openGroup(std::make_shared<FlushGroup>()), flushing(false) {}
+
+MealLog::MealLog(const std::string& logFile)
+    : logFile(logFile), rotatedFile(logFile + ".old"), out(nullptr), recordCount(0),
+      openGroup(std::make_shared<FlushGroup>()), flushing(false) {}
+
+MealLog::~MealLog() {
+    close();
+}
+
+bool MealLog::openLocked() {
+    if (out) {
+        return true;
+    }
+    out = std::fopen(logFile.c_str(), "ab");
+    return out != nullptr;
+}
+
+void MealLog::closeLocked() {
+    if (out) {
+        std::fclose(out);
+        out = nullptr;
+    }
+}
+
+bool MealLog::open() {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    return openLocked();
+}
+
+void MealLog::close() {
+    std::unique_lock<std::mutex> lock(groupMutex);
+    groupCv.wait(lock, [this] { return !flushing; });
+    flushPendingLocked();
+    closeLocked();
+}
+
+std::string MealLog::insertRecord(const Meal& meal) {
+    return "I|" + meal.toString();
+}
+
+std::string MealLog::updateRecord(const Meal& meal) {
+    return "U|" + meal.toString();
+}
+
+std::string MealLog::deleteRecord(int mealId) {
+    return "D|" + std::to_string(mealId);
+}
+
+bool MealLog::writeAndSync(const std::string& data) {
+    if (data.empty()) {
+        return true;
+    }
+    if (!out) {
+        return false;
+    }
+    if (std::fwrite(data.data(), 1, data.size(), out) != data.size()) {
+        return false;
+    }
+    return FileSync::syncStream(out);
+}
+
+void MealLog::flushPendingLocked() {
+    // 调用方持有 groupMutex 且没有其他线程在写
+    if (pending.empty()) {
+        return;
+    }
+    std::string data;
+    data.swap(pending);
+    auto group = openGroup;
+    openGroup = std::make_shared<FlushGroup>();
+    group->ok = openLocked() && writeAndSync(data);
+    group->done = true;
+    groupCv.notify_all();
+}
+
+MealLog::Ticket MealLog::enqueue(const std::vector<std::string>& records) {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    if (records.size() > 1) {
+        pending += "B|" + std::to_string(records.size()) + "\n";
+    }
+    for (const auto& record : records) {
+        pending += record;
+        pending += '\n';
+    }
+    recordCount += records.size();
+    return openGroup;
+}
+
+bool MealLog::wait(const Ticket& ticket) {
+    std::unique_lock<std::mutex> lock(groupMutex);
+    while (!ticket->done) {
+        if (flushing) {
+            groupCv.wait(lock);
+            continue;
+        }
+
+        // 成为本组的提交者：把目前排队的所有批次一次写入并 fsync
+        flushing = true;
+        std::string data;
+        data.swap(pending);
+        auto group = openGroup;
+        openGroup = std::make_shared<FlushGroup>();
+        bool opened = openLocked();
+
+        lock.unlock();
+        bool ok = opened && writeAndSync(data);
+        lock.lock();
+
+        group->ok = ok;
+        group->done = true;
+        flushing = false;
+        groupCv.notify_all();
+    }
+    return ticket->ok;
+}
+
+bool MealLog::sync() {
+    Ticket ticket;
+    {
+        std::lock_guard<std::mutex> lock(groupMutex);
+        if (pending.empty() && !flushing) {
+            return true;
+        }
+        ticket = openGroup;
+    }
+    return wait(ticket);
+}
+
+bool MealLog::replayFile(const std::string& path,
+                         const std::function<void(char op, const std::string& payload)>& apply) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<std::pair<char, std::string>> batch;
+    size_t expected = 0;
+    bool batchCorrupt = false;
+    // 批次头无法解析时不知道批次有多长，丢弃其后的记录直到下一个批次头
+    bool headerCorrupt = false;
+    // validEnd 为最后一条完整记录（或完整批次）之后的位置
+    std::streamoff validEnd = 0;
+    std::streamoff batchStart = 0;
+
+    std::string line;
+    while (true) {
+        std::streamoff lineStart = file.tellg();
+        if (!std::getline(file, line)) break;
+        // 每条记录都以换行结尾，没有换行的最后一行是崩溃时写了一半的记录
+        bool terminated = !file.eof();
+        std::streamoff lineEnd = terminated ? static_cast<std::streamoff>(file.tellg()) : lineStart;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) {
+            if (terminated && expected == 0 && !headerCorrupt) validEnd = lineEnd;
+            continue;
+        }
+
+        if (line.size() > 2 && line[0] == 'B' && line[1] == '|') {
+            batchStart = lineStart;
+            if (expected > 0) {
+                std::cout << "Discarding incomplete meal log batch in " << path << std::endl;
+            }
+            if (headerCorrupt) {
+                std::cout << "Discarding corrupt meal log batch in " << path << std::endl;
+            }
+            batch.clear();
+            batchCorrupt = false;
+            headerCorrupt = false;
+            expected = 0;
+            int count = 0;
+            try {
+                count = TextParser::toInt(std::string_view(line).substr(2));
+            } catch (const std::exception&) {
+            }
+            if (count > 0) {
+                expected = static_cast<size_t>(count);
+            } else {
+                std::cout << "Error parsing meal log line: " << line << std::endl;
+                headerCorrupt = true;
+            }
+            continue;
+        }
+        if (headerCorrupt) {
+            continue;
+        }
+
+        bool valid = terminated && line.size() >= 2 && line[1] == '|' &&
+                     (line[0] == 'I' || line[0] == 'U' || line[0] == 'D');
+        if (!valid) {
+            std::cout << "Error parsing meal log line: " << line << std::endl;
+            if (expected > 0) batchCorrupt = true;
+        }
+
+        if (expected == 0) {
+            if (valid) {
+                apply(line[0], line.substr(2));
+                ++recordCount;
+            }
+            if (terminated) validEnd = lineEnd;
+            continue;
+        }
+
+        batch.emplace_back(line[0], valid ? line.substr(2) : std::string());
+        if (batch.size() == expected) {
+            if (batchCorrupt) {
+                std::cout << "Discarding corrupt meal log batch in " << path << std::endl;
+            } else {
+                for (const auto& record : batch) {
+                    apply(record.first, record.second);
+                }
+                recordCount += batch.size();
+            }
+            batch.clear();
+            expected = 0;
+            if (terminated) validEnd = lineEnd;
+        }
+    }
+
+    if (expected > 0 || headerCorrupt) {
+        std::cout << "Discarding " << (headerCorrupt ? "corrupt" : "incomplete")
+                  << " meal log batch in " << path << std::endl;
+        validEnd = std::min(validEnd, batchStart);
+    }
+
+    // 截掉末尾不完整的部分，避免之后追加的记录与半行拼接或被计入残缺批次
+    file.close();
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(path, ec);
+    if (!ec && static_cast<std::streamoff>(fileSize) > validEnd) {
+        std::filesystem::resize_file(path, static_cast<uintmax_t>(validEnd), ec);
+    }
+    return true;
+}
+
+bool MealLog::replay(const std::function<void(char op, const std::string& payload)>& apply) {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    recordCount = 0;
+    bool hasRotated = replayFile(rotatedFile, apply);
+    bool hasCurrent = replayFile(logFile, apply);
+    return hasRotated || hasCurrent;
+}
+
+bool MealLog::rotate() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    std::unique_lock<std::mutex> lock(groupMutex);
+    groupCv.wait(lock, [this] { return !flushing; });
+    // 已排队但未落盘的记录属于轮转前的状态，先写进旧日志
+    flushPendingLocked();
+    closeLocked();
+
+    if (fs::exists(rotatedFile, ec)) {
+        // 上次压缩没有完成，把当前日志接到 .old 后面，保持记录顺序
+        std::ifstream in(logFile, std::ios::binary);
+        std::ofstream old(rotatedFile, std::ios::out | std::ios::app | std::ios::binary);
+        if (!old.is_open()) {
+            openLocked();
+            return false;
+        }
+        if (in.is_open()) {
+            old << in.rdbuf();
+        }
+        old.close();
+        in.close();
+        // 当前日志要等接上的内容在 .old 中落盘后才能删除
+        if (!old || !FileSync::syncFile(rotatedFile)) {
+            openLocked();
+            return false;
+        }
+        fs::remove(logFile, ec);
+    } else if (fs::exists(logFile, ec)) {
+        fs::rename(logFile, rotatedFile, ec);
+        if (ec) {
+            openLocked();
+            return false;
+        }
+        FileSync::syncParentDirectory(logFile);
+    }
+
+    recordCount = 0;
+    return openLocked();
+}
+
+void MealLog::discardRotated() {
+    std::error_code ec;
+    std::filesystem::remove(rotatedFile, ec);
+}
+
+size_t MealLog::getRecordCount() {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    return recordCount;
+}
@@ -0,0 +1,108 @@
+#include "../include/MealTemplates.h"
+#include "../include/TextParser.h"
+#include <iostream>
+
+namespace {
+
+struct BuiltinSlot {
+    const char* category;
+    double share;
+};
+
+struct BuiltinTemplate {
+    const char* mealType;
+    const BuiltinSlot* slots;
+    size_t count;
+};
+
+constexpr BuiltinSlot kBreakfast[] = {{u8"主食", 0.4}, {u8"蛋类", 0.3}, {u8"奶制品", 0.2}, {u8"水果", 0.1}};
+constexpr BuiltinSlot kLunch[] = {{u8"主食", 0.35}, {u8"肉类", 0.4}, {u8"蔬菜", 0.25}};
+constexpr BuiltinSlot kDinner[] = {{u8"主食", 0.3}, {u8"蔬菜", 0.3}, {u8"豆制品", 0.25}, {u8"肉类", 0.15}};
+constexpr BuiltinSlot kSnack[] = {{u8"水果", 0.7}, {u8"坚果", 0.3}};
+
+// 按 MealKind 的顺序排列
+constexpr BuiltinTemplate kBuiltinTemplates[MealTemplates::kKinds] = {
+    {"breakfast", kBreakfast, sizeof(kBreakfast) / sizeof(kBreakfast[0])},
+    {"lunch", kLunch, sizeof(kLunch) / sizeof(kLunch[0])},
+    {"dinner", kDinner, sizeof(kDinner) / sizeof(kDinner[0])},
+    {"snack", kSnack, sizeof(kSnack) / sizeof(kSnack[0])},
+};
+
+// 餐类型名必须是四种之一，未知的名称返回 false
+bool parseKindName(std::string_view name, size_t& kind) {
+    for (size_t i = 0; i < MealTemplates::kKinds; ++i) {
+        if (name == kBuiltinTemplates[i].mealType) {
+            kind = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "类别:比例,类别:比例"，比例须为正数
+bool parseSlots(std::string_view str, std::vector<MealTemplates::Slot>& slots) {
+    std::vector<std::string_view> items;
+    TextParser::split(str, ',', items);
+    slots.clear();
+    for (std::string_view item : items) {
+        size_t sep = item.rfind(':');
+        if (sep == std::string_view::npos || sep == 0) {
+            return false;
+        }
+        double share = 0.0;
+        try {
+            share = TextParser::toDouble(item.substr(sep + 1));
+        } catch (const std::exception&) {
+            return false;
+        }
+        if (!(share > 0)) {
+            return false;
+        }
+        slots.push_back({std::string(item.substr(0, sep)), share});
+    }
+    return !slots.empty();
+}
+
+}
+
+MealTemplates::MealTemplates() {
+    for (size_t kind = 0; kind < kKinds; ++kind) {
+        const BuiltinTemplate& builtin = kBuiltinTemplates[kind];
+        for (size_t i = 0; i < builtin.count; ++i) {
+            slots[kind].push_back({builtin.slots[i].category, builtin.slots[i].share});
+        }
+    }
+}
+
+bool MealTemplates::loadFile(const std::string& path) {
+    std::string buffer;
+    if (!TextParser::readFile(path, buffer)) {
+        return false;
+    }
+
+    TextParser::LineReader reader(buffer);
+    std::vector<std::string_view> tokens;
+    std::vector<Slot> parsed;
+    std::string_view line;
+    while (reader.next(line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t kind = 0;
+        if (TextParser::split(line, '|', tokens) != 2 || !parseKindName(tokens[0], kind) ||
+            !parseSlots(tokens[1], parsed)) {
+            std::cout << "Error parsing meal template line: " << line << std::endl;
+            continue;
+        }
+        slots[kind] = parsed;
+    }
+    return true;
+}
+
+MealKind MealTemplates::kindOf(std::string_view mealType) {
+    size_t kind = 0;
+    return parseKindName(mealType, kind) ? static_cast<MealKind>(kind) : MealKind::Snack;
+}
+
+const char* MealTemplates::nameOf(MealKind kind) {
+    return kBuiltinTemplates[static_cast<size_t>(kind)].mealType;
+}
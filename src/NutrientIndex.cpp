@@ -0,0 +1,148 @@
+#include "../include/NutrientIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+
+NutrientIndex::NutrientIndex(const FoodCatalog& catalog, const std::vector<size_t>& rows) : rows(rows) {
+    const double* columns[kDims] = {catalog.getCalorieColumn(), catalog.getProteinColumn(),
+                                    catalog.getCarbColumn(), catalog.getFatColumn()};
+    coords.resize(rows.size() * kDims);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        for (int d = 0; d < kDims; ++d) {
+            coords[i * kDims + d] = columns[d][rows[i]];
+        }
+    }
+    if (rows.empty()) {
+        return;
+    }
+
+    // 各维标准差，只用于选择分割维
+    double scale[kDims];
+    for (int d = 0; d < kDims; ++d) {
+        double mean = 0.0;
+        for (size_t i = 0; i < rows.size(); ++i) mean += coords[i * kDims + d];
+        mean /= rows.size();
+        double variance = 0.0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            double diff = coords[i * kDims + d] - mean;
+            variance += diff * diff;
+        }
+        scale[d] = variance > 0 ? std::sqrt(variance / rows.size()) : 1.0;
+    }
+    nodes.reserve(2 * rows.size() / kLeafSize + 1);
+    build(0, static_cast<uint32_t>(rows.size()), scale);
+}
+
+int32_t NutrientIndex::build(uint32_t begin, uint32_t end, const double* scale) {
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.left = -1;
+    node.right = -1;
+    for (int d = 0; d < kDims; ++d) {
+        node.lo[d] = coords[begin * kDims + d];
+        node.hi[d] = coords[begin * kDims + d];
+    }
+    for (uint32_t i = begin + 1; i < end; ++i) {
+        for (int d = 0; d < kDims; ++d) {
+            node.lo[d] = std::min(node.lo[d], coords[i * kDims + d]);
+            node.hi[d] = std::max(node.hi[d], coords[i * kDims + d]);
+        }
+    }
+
+    int32_t index = static_cast<int32_t>(nodes.size());
+    nodes.push_back(node);
+    if (end - begin <= kLeafSize) {
+        return index;
+    }
+
+    int split = 0;
+    for (int d = 1; d < kDims; ++d) {
+        if ((node.hi[d] - node.lo[d]) / scale[d] > (node.hi[split] - node.lo[split]) / scale[split]) {
+            split = d;
+        }
+    }
+    if (node.hi[split] == node.lo[split]) {
+        return index;   // 所有点重合，不再分割
+    }
+
+    // 按分割维的中位数把范围分成两半，rows 和 coords 同步重排
+    std::vector<uint32_t> order(end - begin);
+    std::iota(order.begin(), order.end(), begin);
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin(), order.begin() + (middle - begin), order.end(),
+                     [this, split](uint32_t a, uint32_t b) {
+                         return coords[a * kDims + split] < coords[b * kDims + split];
+                     });
+    std::vector<size_t> sortedRows(order.size());
+    std::vector<double> sortedCoords(order.size() * kDims);
+    for (size_t i = 0; i < order.size(); ++i) {
+        sortedRows[i] = rows[order[i]];
+        std::copy(&coords[order[i] * kDims], &coords[order[i] * kDims] + kDims, &sortedCoords[i * kDims]);
+    }
+    std::copy(sortedRows.begin(), sortedRows.end(), rows.begin() + begin);
+    std::copy(sortedCoords.begin(), sortedCoords.end(), coords.begin() + begin * kDims);
+
+    int32_t left = build(begin, middle, scale);
+    int32_t right = build(middle, end, scale);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+}
+
+void NutrientIndex::forEachNearest(const double* query, const double* weights,
+                                   const std::function<bool(size_t, double)>& visit) const {
+    if (nodes.empty()) {
+        return;
+    }
+
+    // 节点和点放在同一个按距离排列的小顶堆里：节点的距离是到其包围盒的距离，
+    // 不大于子树中任一点的距离，因此点出堆的顺序就是距离从小到大的顺序
+    struct Entry {
+        double distance;
+        uint32_t index;
+        bool isPoint;
+
+        bool operator>(const Entry& other) const { return distance > other.distance; }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pending;
+
+    auto boxDistance = [query, weights](const Node& node) {
+        double distance = 0.0;
+        for (int d = 0; d < kDims; ++d) {
+            if (query[d] < node.lo[d]) {
+                distance += weights[d] * (node.lo[d] - query[d]);
+            } else if (query[d] > node.hi[d]) {
+                distance += weights[d] * (query[d] - node.hi[d]);
+            }
+        }
+        return distance;
+    };
+
+    pending.push({boxDistance(nodes[0]), 0, false});
+    while (!pending.empty()) {
+        Entry entry = pending.top();
+        pending.pop();
+        if (entry.isPoint) {
+            if (!visit(rows[entry.index], entry.distance)) {
+                return;
+            }
+            continue;
+        }
+
+        const Node& node = nodes[entry.index];
+        if (node.left < 0) {
+            for (uint32_t i = node.begin; i < node.end; ++i) {
+                double distance = 0.0;
+                for (int d = 0; d < kDims; ++d) {
+                    distance += weights[d] * std::fabs(coords[i * kDims + d] - query[d]);
+                }
+                pending.push({distance, i, true});
+            }
+        } else {
+            pending.push({boxDistance(nodes[node.left]), static_cast<uint32_t>(node.left), false});
+            pending.push({boxDistance(nodes[node.right]), static_cast<uint32_t>(node.right), false});
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#include "../include/RecentFoodWindow.h"
+#include <algorithm>
+
+size_t RecentFoodWindow::windowStart() const {
+    return meals.size() > kWindowSize ? meals.size() - kWindowSize : 0;
+}
+
+void RecentFoodWindow::countMeal(const Entry& entry, int delta) {
+    for (int foodId : entry.foodIds) {
+        auto it = counts.emplace(foodId, 0).first;
+        it->second += delta;
+        if (it->second == 0) {
+            counts.erase(it);
+        }
+    }
+}
+
+void RecentFoodWindow::add(const Meal& meal) {
+    if (meals.size() >= kWindowSize) {
+        // 最早的一餐滑出窗口
+        countMeal(meals[meals.size() - kWindowSize], -1);
+    }
+    meals.push_back({meal.getId(), meal.getDay(), meal.getFoodIds()});
+    countMeal(meals.back(), 1);
+}
+
+bool RecentFoodWindow::remove(int mealId) {
+    // 最近的餐最常被删除或替换，从后往前找
+    auto it = std::find_if(meals.rbegin(), meals.rend(),
+                           [mealId](const Entry& entry) { return entry.mealId == mealId; });
+    if (it == meals.rend()) {
+        return false;
+    }
+    removeAt(static_cast<size_t>(meals.rend() - it) - 1);
+    return true;
+}
+
+int RecentFoodWindow::removeDay(const Date& day) {
+    int removed = 0;
+    for (size_t i = meals.size(); i-- > 0;) {
+        if (meals[i].day == day) {
+            removeAt(i);
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+void RecentFoodWindow::removeAt(size_t position) {
+    bool inWindow = position >= windowStart();
+    if (inWindow) {
+        countMeal(meals[position], -1);
+    }
+    meals.erase(meals.begin() + position);
+    if (inWindow && meals.size() >= kWindowSize) {
+        // 窗口前面的一餐补进来
+        countMeal(meals[meals.size() - kWindowSize], 1);
+    }
+}
+
+int RecentFoodWindow::count(int foodId) const {
+    auto it = counts.find(foodId);
+    return it == counts.end() ? 0 : it->second;
+}
+
+size_t RecentFoodWindow::windowSize() const {
+    return std::min(meals.size(), kWindowSize);
+}
+
+RecentFoodWindow RecentFoodWindow::recentOnly() const {
+    RecentFoodWindow copy;
+    copy.meals.assign(meals.begin() + windowStart(), meals.end());
+    copy.counts = counts;
+    return copy;
+}
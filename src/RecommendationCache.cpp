@@ -0,0 +1,88 @@
+#include "../include/RecommendationCache.h"
+
+PlanInputs PlanInputs::of(const User& user, uint64_t catalogVersion, uint64_t historyVersion, PlanMode mode) {
+    return {catalogVersion, historyVersion,
+            user.getDailyCalorieGoal(), user.getDailyProteinGoal(),
+            user.getDailyCarbGoal(), user.getDailyFatGoal(),
+            user.getPreferredTagMask(), user.getAvoidedTagMask(), user.getAllergenMask(), mode};
+}
+
+bool PlanInputs::operator==(const PlanInputs& other) const {
+    return catalogVersion == other.catalogVersion && historyVersion == other.historyVersion &&
+           calorieGoal == other.calorieGoal && proteinGoal == other.proteinGoal &&
+           carbGoal == other.carbGoal && fatGoal == other.fatGoal &&
+           preferredTags == other.preferredTags && avoidedTags == other.avoidedTags &&
+           allergens == other.allergens && mode == other.mode;
+}
+
+RecommendationCache::RecommendationCache(size_t capacity)
+    : capacity(capacity), hits(0), misses(0), evictions(0), invalidations(0) {}
+
+bool RecommendationCache::find(int userId, const Date& date, const PlanInputs& inputs,
+                               PlanResult& plan) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find({userId, date.toDays()});
+    if (it == index.end()) {
+        ++misses;
+        return false;
+    }
+    if (it->second->inputs != inputs) {
+        entries.erase(it->second);
+        index.erase(it);
+        ++invalidations;
+        ++misses;
+        return false;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    plan = it->second->plan;
+    ++hits;
+    return true;
+}
+
+void RecommendationCache::store(int userId, const Date& date, const PlanInputs& inputs,
+                                const PlanResult& plan) {
+    if (capacity == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    Key key = {userId, date.toDays()};
+    auto it = index.find(key);
+    if (it != index.end()) {
+        it->second->inputs = inputs;
+        it->second->plan = plan;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    entries.push_front({key, inputs, plan});
+    index.emplace(key, entries.begin());
+    if (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++evictions;
+    }
+}
+
+void RecommendationCache::invalidateUser(int userId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->key.userId == userId) {
+            index.erase(it->key);
+            it = entries.erase(it);
+            ++invalidations;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RecommendationCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    invalidations += entries.size();
+    entries.clear();
+    index.clear();
+}
+
+RecommendationCache::Stats RecommendationCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {hits, misses, evictions, invalidations, entries.size(), capacity};
+}
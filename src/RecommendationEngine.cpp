@@ -1,125 +1,228 @@
 #include "../include/RecommendationEngine.h"
+#include "../include/TopK.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <map>
 
-RecommendationEngine::RecommendationEngine() {}
+const RecommendationEngine::MealShare RecommendationEngine::kDailyMeals[3] = {
+    {MealKind::Breakfast, 0.3, 0.25, 0.3, 0.3},
+    {MealKind::Lunch, 0.4, 0.4, 0.4, 0.4},
+    {MealKind::Dinner, 0.3, 0.35, 0.3, 0.3},
+};
 
-void RecommendationEngine::setFoodDatabase(const std::vector<Food>& foods) {
-    foodDatabase = foods;
+namespace {
+// 全天联合配餐的附加代价，与营养相对偏差同一量纲：
+// 最近吃过的食物每出现一次加 0.05，每个匹配的偏好标签减 0.02
+const double kBalancedRepeatCost = 0.05;
+const double kBalancedPreferredBonus = 0.02;
 }
 
-void RecommendationEngine::addToHistory(int userId, const Meal& meal) {
-    userHistory[userId].push_back(meal);
+RecommendationEngine::RecommendationEngine()
+    : catalog(FoodCatalog::current()), historyClock(0), historyLoadedAt(0) {
+    rebuildCandidateIndex();
 }
 
-void RecommendationEngine::loadHistory(const std::map<int, std::vector<Meal>>& history) {
-    userHistory = history;
+void RecommendationEngine::setFoodCatalog(std::shared_ptr<const FoodCatalog> catalog) {
+    if (catalog) {
+        this->catalog = std::move(catalog);
+        rebuildCandidateIndex();
+    }
 }
 
-bool RecommendationEngine::isAllergenFree(const Food& food, const User& user) const {
-    for (const auto& allergen : user.getAllergens()) {
-        if (food.hasTag(allergen)) {
-            return false;
+void RecommendationEngine::setFoodDatabase(const std::vector<Food>& foods) {
+    catalog = std::make_shared<const FoodCatalog>(foods);
+    rebuildCandidateIndex();
+}
+
+void RecommendationEngine::setMealTemplates(const MealTemplates& templates) {
+    mealTemplates = templates;
+    compileTemplates();
+}
+
+void RecommendationEngine::compileTemplates() {
+    for (size_t kind = 0; kind < MealTemplates::kKinds; ++kind) {
+        std::vector<TemplateSlot>& compiled = compiledTemplates[kind];
+        compiled.clear();
+        for (const auto& slot : mealTemplates.get(static_cast<MealKind>(kind))) {
+            int categoryId = catalog->findCategory(slot.category);
+            if (categoryId >= 0) {
+                compiled.push_back({categoryId, slot.share});
+            }
         }
     }
+}
+
+void RecommendationEngine::rebuildCandidateIndex() {
+    categoryCandidates.assign(catalog->getCategoryCount(), std::vector<size_t>());
+    const int* categoryIds = catalog->getCategoryColumn();
+    for (size_t i = 0; i < catalog->size(); ++i) {
+        categoryCandidates[categoryIds[i]].push_back(i);
+    }
+
+    std::vector<size_t> allRows(catalog->size());
+    for (size_t i = 0; i < allRows.size(); ++i) {
+        allRows[i] = i;
+    }
+    nutrientIndex = NutrientIndex(*catalog, allRows);
+    categoryNutrientIndexes.clear();
+    categoryNutrientIndexes.reserve(categoryCandidates.size());
+    for (const auto& rows : categoryCandidates) {
+        categoryNutrientIndexes.emplace_back(*catalog, rows);
+    }
+    compileTemplates();
+}
+
+void RecommendationEngine::touchHistory(int userId) {
+    historyVersions[userId] = ++historyClock;
+}
+
+void RecommendationEngine::addToHistory(int userId, const Meal& meal) {
+    std::unique_lock<std::shared_mutex> lock(historyMutex);
+    userHistory[userId].add(meal);
+    touchHistory(userId);
+}
+
+bool RecommendationEngine::removeFromHistory(int userId, int mealId) {
+    std::unique_lock<std::shared_mutex> lock(historyMutex);
+    auto history = userHistory.find(userId);
+    if (history == userHistory.end() || !history->second.remove(mealId)) {
+        return false;
+    }
+    touchHistory(userId);
     return true;
 }
 
-double RecommendationEngine::calculateFoodScore(const Food& food, const User& user,
-                                                 const std::string& mealType,
-                                                 double remainingCalories,
-                                                 double remainingProtein,
-                                                 double remainingCarbs,
-                                                 double remainingFat) const {
-    (void)mealType;
-    
-    double score = 100.0;
-    
-    if (!isAllergenFree(food, user)) {
-        return -1000.0;
+int RecommendationEngine::replaceHistoryDay(int userId, const Date& day, const std::vector<Meal>& meals) {
+    std::unique_lock<std::shared_mutex> lock(historyMutex);
+    RecentFoodWindow& window = userHistory[userId];
+    int removed = window.removeDay(day);
+    for (const auto& meal : meals) {
+        window.add(meal);
     }
-    
-    for (const auto& avoidedTag : user.getAvoidedTags()) {
-        if (food.hasTag(avoidedTag)) {
-            score -= 50.0;
-        }
+    if (removed > 0 || !meals.empty()) {
+        touchHistory(userId);
     }
-    
-    for (const auto& preferredTag : user.getPreferredTags()) {
-        if (food.hasTag(preferredTag)) {
-            score += 30.0;
+    return removed;
+}
+
+uint64_t RecommendationEngine::getHistoryVersion(int userId) const {
+    std::shared_lock<std::shared_mutex> lock(historyMutex);
+    auto it = historyVersions.find(userId);
+    return it == historyVersions.end() ? historyLoadedAt : it->second;
+}
+
+void RecommendationEngine::loadHistory(const std::map<int, std::vector<Meal>>& history) {
+    std::unique_lock<std::shared_mutex> lock(historyMutex);
+    historyVersions.clear();
+    historyLoadedAt = ++historyClock;
+    userHistory.clear();
+    for (const auto& entry : history) {
+        RecentFoodWindow& window = userHistory[entry.first];
+        for (const auto& meal : entry.second) {
+            window.add(meal);
         }
     }
-    
-    // 营养平衡评分
-    double nutritionScore = 0.0;
-    if (remainingCalories > 0) {
-        double calorieRatio = food.getCalories() / remainingCalories;
-        nutritionScore += 20.0 * (1.0 - std::abs(calorieRatio - 1.0));
-    }
-    
-    if (remainingProtein > 0) {
-        double proteinRatio = food.getProtein() / remainingProtein;
-        nutritionScore += 25.0 * (1.0 - std::abs(proteinRatio - 1.0));
+}
+
+bool ScoringProfile::matches(const User& user) const {
+    return userId == user.getId() &&
+           preferences.preferred == user.getPreferredTagMask() &&
+           preferences.avoided == user.getAvoidedTagMask() &&
+           preferences.allergens == user.getAllergenMask() &&
+           dailyGoals.calories == user.getDailyCalorieGoal() &&
+           dailyGoals.protein == user.getDailyProteinGoal() &&
+           dailyGoals.carbs == user.getDailyCarbGoal() &&
+           dailyGoals.fat == user.getDailyFatGoal();
+}
+
+std::shared_ptr<const ScoringProfile> RecommendationEngine::profileFor(const User& user) const {
+    uint64_t historyVersion = getHistoryVersion(user.getId());
+    {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        auto cached = profiles.find(user.getId());
+        if (cached != profiles.end() && cached->second->historyVersion == historyVersion &&
+            cached->second->matches(user)) {
+            return cached->second;
+        }
     }
     
-    if (remainingCarbs > 0) {
-        double carbRatio = food.getCarbohydrates() / remainingCarbs;
-        nutritionScore += 15.0 * (1.0 - std::abs(carbRatio - 1.0));
+    auto profile = std::make_shared<ScoringProfile>();
+    profile->userId = user.getId();
+    profile->preferences = {user.getPreferredTagMask(), user.getAvoidedTagMask(), user.getAllergenMask()};
+    profile->dailyGoals = {user.getDailyCalorieGoal(), user.getDailyProteinGoal(),
+                           user.getDailyCarbGoal(), user.getDailyFatGoal()};
+    {
+        // 版本和历史在同一把锁下读取，两者一定对应；之后打分不再访问 userHistory
+        std::shared_lock<std::shared_mutex> lock(historyMutex);
+        auto versioned = historyVersions.find(user.getId());
+        profile->historyVersion = versioned == historyVersions.end() ? historyLoadedAt : versioned->second;
+        auto history = userHistory.find(user.getId());
+        profile->history = std::make_shared<const RecentFoodWindow>(
+            history == userHistory.end() ? RecentFoodWindow() : history->second.recentOnly());
     }
     
-    if (remainingFat > 0) {
-        double fatRatio = food.getFat() / remainingFat;
-        nutritionScore += 10.0 * (1.0 - std::abs(fatRatio - 1.0));
+    std::lock_guard<std::mutex> lock(profileMutex);
+    std::shared_ptr<const ScoringProfile>& cached = profiles[user.getId()];
+    // 并发编译时保留历史较新的一份
+    if (!cached || cached->historyVersion <= profile->historyVersion) {
+        cached = profile;
     }
+    return profile;
+}
+
+void RecommendationEngine::invalidateProfile(int userId) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    profiles.erase(userId);
+}
+
+double RecommendationEngine::applyDiversityPenalty(const RecentFoodWindow& history, int foodId, double score) {
+    // 避免重复推荐最近吃过的食物
+    int recentCount = history.count(foodId);
+    int recentLimit = static_cast<int>(history.windowSize());
+    score -= recentCount * 15.0;
     
-    score += nutritionScore;
-    
-    // 多样性评分 - 避免重复推荐相同食物
-    auto history = userHistory.find(user.getId());
-    if (history != userHistory.end()) {
-        int recentCount = 0;
-        int historySize = history->second.size();
-        int recentLimit = std::min(10, historySize);
-        
-        for (int i = historySize - recentLimit; i < historySize; ++i) {
-            if (i >= 0) {
-                const auto& pastMeal = history->second[i];
-                for (const auto& pastFood : pastMeal.getFoods()) {
-                    if (pastFood.getId() == food.getId()) {
-                        recentCount++;
-                    }
-                }
-            }
-        }
-        score -= recentCount * 15.0;
-        
-        if (recentCount > 0 && recentLimit > 0) {
-            double recencyWeight = static_cast<double>(recentCount) / recentLimit;
-            score -= recencyWeight * 20.0;
-        }
+    if (recentCount > 0 && recentLimit > 0) {
+        double recencyWeight = static_cast<double>(recentCount) / recentLimit;
+        score -= recencyWeight * 20.0;
     }
     
     return score;
 }
 
-std::vector<Food> RecommendationEngine::filterFoodsByCategory(const std::string& category) const {
-    std::vector<Food> filtered;
-    for (const auto& food : foodDatabase) {
-        if (food.getCategory() == category) {
-            filtered.push_back(food);
+std::vector<std::pair<double, size_t>> RecommendationEngine::topCandidates(const ScoringProfile& profile,
+                                                                          const std::vector<size_t>& rows,
+                                                                          const ScoringKernel::Targets& targets,
+                                                                          size_t k) const {
+    std::vector<double> scores(rows.size());
+    ScoringKernel::scoreRows(*catalog, rows.data(), rows.size(), profile.preferences, targets, scores.data());
+
+    // 含过敏原的食物得分为 -1000，扣分后仍低于 -500，会在这里被滤掉
+    const int* ids = catalog->getIdColumn();
+    TopK<std::pair<double, size_t>, HigherScoreFirst> best(k);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        double score = applyDiversityPenalty(*profile.history, ids[rows[i]], scores[i]);
+        if (score > -500) {
+            best.push({score, rows[i]});
         }
     }
-    return filtered;
+    return best.take();
 }
 
 Meal RecommendationEngine::recommendMeal(const User& user, const std::string& mealType,
                                          double targetCalories, double targetProtein,
                                          double targetCarbs, double targetFat) {
-    Meal meal(0, user.getId(), "", mealType);
+    Meal meal = planMeal(*profileFor(user), MealTemplates::kindOf(mealType),
+                         targetCalories, targetProtein, targetCarbs, targetFat);
+    meal.setMealType(mealType);
+    return meal;
+}
+
+Meal RecommendationEngine::planMeal(const ScoringProfile& profile, MealKind kind,
+                                    double targetCalories, double targetProtein,
+                                    double targetCarbs, double targetFat) const {
+    Meal meal(0, profile.userId, "", MealTemplates::nameOf(kind));
     meal.setIsRecommended(true);
     
     double remainingCalories = targetCalories;
@@ -127,58 +230,19 @@ Meal RecommendationEngine::recommendMeal(const User& user, const std::string& me
     double remainingCarbs = targetCarbs;
     double remainingFat = targetFat;
     
-    std::vector<std::string> categories;
-    std::map<std::string, double> categoryWeights;
-    
-    if (mealType == "breakfast") {
-        categories = {u8"主食", u8"蛋类", u8"奶制品", u8"水果"};
-        categoryWeights[u8"主食"] = 0.4;
-        categoryWeights[u8"蛋类"] = 0.3;
-        categoryWeights[u8"奶制品"] = 0.2;
-        categoryWeights[u8"水果"] = 0.1;
-    } else if (mealType == "lunch") {
-        categories = {u8"主食", u8"肉类", u8"蔬菜"};
-        categoryWeights[u8"主食"] = 0.35;
-        categoryWeights[u8"肉类"] = 0.4;
-        categoryWeights[u8"蔬菜"] = 0.25;
-    } else if (mealType == "dinner") {
-        categories = {u8"主食", u8"蔬菜", u8"豆制品", u8"肉类"};
-        categoryWeights[u8"主食"] = 0.3;
-        categoryWeights[u8"蔬菜"] = 0.3;
-        categoryWeights[u8"豆制品"] = 0.25;
-        categoryWeights[u8"肉类"] = 0.15;
-    } else {
-        categories = {u8"水果", u8"坚果"};
-        categoryWeights[u8"水果"] = 0.7;
-        categoryWeights[u8"坚果"] = 0.3;
-    }
-    
-    for (const auto& category : categories) {
-        std::vector<Food> categoryFoods = filterFoodsByCategory(category);
-        if (categoryFoods.empty()) continue;
+    for (const TemplateSlot& slot : templateFor(kind)) {
+        const std::vector<size_t>& categoryFoods = categoryCandidates[slot.categoryId];
         
-        double categoryCalTarget = targetCalories * categoryWeights[category];
-        double categoryProtTarget = targetProtein * categoryWeights[category];
-        double categoryCarbTarget = targetCarbs * categoryWeights[category];
-        double categoryFatTarget = targetFat * categoryWeights[category];
+        ScoringKernel::Targets categoryTargets = {targetCalories * slot.share,
+                                                  targetProtein * slot.share,
+                                                  targetCarbs * slot.share,
+                                                  targetFat * slot.share};
         
-        std::vector<std::pair<double, Food>> scoredFoods;
-        for (const auto& food : categoryFoods) {
-            double score = calculateFoodScore(food, user, mealType,
-                                             categoryCalTarget,
-                                             categoryProtTarget,
-                                             categoryCarbTarget,
-                                             categoryFatTarget);
-            if (score > -500) {
-                scoredFoods.push_back({score, food});
-            }
-        }
+        // 只在前三名里挑选
+        std::vector<std::pair<double, size_t>> scoredFoods = topCandidates(profile, categoryFoods, categoryTargets, 3);
         
         if (!scoredFoods.empty()) {
-            std::sort(scoredFoods.begin(), scoredFoods.end(),
-                     [](const auto& a, const auto& b) { return a.first > b.first; });
-            
-            size_t topChoices = std::min(static_cast<size_t>(3), scoredFoods.size());
+            size_t topChoices = scoredFoods.size();
             size_t selectedIndex = 0;
             
             if (topChoices > 1) {
@@ -190,74 +254,263 @@ Meal RecommendationEngine::recommendMeal(const User& user, const std::string& me
                 }
             }
             
-            meal.addFood(scoredFoods[selectedIndex].second);
-            remainingCalories -= scoredFoods[selectedIndex].second.getCalories();
-            remainingProtein -= scoredFoods[selectedIndex].second.getProtein();
-            remainingCarbs -= scoredFoods[selectedIndex].second.getCarbohydrates();
-            remainingFat -= scoredFoods[selectedIndex].second.getFat();
+            const Food& selected = catalog->getFoods()[scoredFoods[selectedIndex].second];
+            meal.addFood(selected);
+            remainingCalories -= selected.getCalories();
+            remainingProtein -= selected.getProtein();
+            remainingCarbs -= selected.getCarbohydrates();
+            remainingFat -= selected.getFat();
         }
     }
     
     return meal;
 }
 
-std::vector<Meal> RecommendationEngine::recommendDailyMeals(const User& user, const std::string& date) {
-    std::vector<Meal> dailyMeals;
+std::vector<Meal> RecommendationEngine::recommendDailyMeals(const User& user, const std::string& date,
+                                                            PlanMode mode) {
+    auto budget = std::chrono::duration<double, std::milli>(plannerOptions.timeBudgetMs);
+    return planDailyMeals(user, date, mode,
+                          std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget)).meals;
+}
+
+PlanResult RecommendationEngine::planDailyMeals(const User& user, const std::string& date, PlanMode mode,
+                                                std::chrono::steady_clock::time_point deadline) {
+    std::shared_ptr<const ScoringProfile> profile = profileFor(user);
+    const ScoringKernel::Targets& goals = profile->dailyGoals;
     
-    double breakfastCalories = user.getDailyCalorieGoal() * 0.3;
-    double lunchCalories = user.getDailyCalorieGoal() * 0.4;
-    double dinnerCalories = user.getDailyCalorieGoal() * 0.3;
+    // 先用逐餐挑选得到一个完整方案，之后的联合配餐只在剩余时间内改进它
+    PlanResult result;
+    result.truncated = false;
+    for (const MealShare& share : kDailyMeals) {
+        result.meals.push_back(planMeal(*profile, share.kind,
+                                        goals.calories * share.calories,
+                                        goals.protein * share.protein,
+                                        goals.carbs * share.carbs,
+                                        goals.fat * share.fat));
+    }
     
-    double breakfastProtein = user.getDailyProteinGoal() * 0.25;
-    double lunchProtein = user.getDailyProteinGoal() * 0.4;
-    double dinnerProtein = user.getDailyProteinGoal() * 0.35;
+    if (mode != PlanMode::Greedy) {
+        double remainingMs = std::chrono::duration<double, std::milli>(
+            deadline - std::chrono::steady_clock::now()).count();
+        bool complete = false;
+        if (remainingMs > 0) {
+            std::vector<Meal> balanced = planBalancedDay(*profile, mode, result.meals, remainingMs, complete);
+            if (!balanced.empty()) {
+                result.meals = std::move(balanced);
+            }
+        }
+        result.truncated = !complete;
+    }
     
-    double breakfastCarbs = user.getDailyCarbGoal() * 0.3;
-    double lunchCarbs = user.getDailyCarbGoal() * 0.4;
-    double dinnerCarbs = user.getDailyCarbGoal() * 0.3;
+    ScoringKernel::Targets totals = {0, 0, 0, 0};
+    for (auto& meal : result.meals) {
+        meal.setDate(date);
+        totals.calories += meal.getTotalCalories();
+        totals.protein += meal.getTotalProtein();
+        totals.carbs += meal.getTotalCarbs();
+        totals.fat += meal.getTotalFat();
+    }
+    result.quality = std::max(0.0, 1.0 - DailyPlanner::deviation(totals, goals) / 4.0);
+    return result;
+}
+
+std::vector<Meal> RecommendationEngine::planBalancedDay(const ScoringProfile& profile, PlanMode mode,
+                                                        const std::vector<Meal>& baseline,
+                                                        double budgetMs, bool& complete) const {
+    TagMask excluded = profile.preferences.allergens | profile.preferences.avoided;
+    const TagMask& preferred = profile.preferences.preferred;
+    const RecentFoodWindow& history = *profile.history;
+    const int* ids = catalog->getIdColumn();
+    const uint64_t* tags = catalog->getTagColumn();
+    const int tagStride = catalog->getTagStride();
+    // 过敏原和忌口是硬约束；最近吃过的食物和偏好标签折算成附加代价
+    auto extraCost = [&](size_t row) {
+        return history.count(ids[row]) * kBalancedRepeatCost -
+               preferred.countShared(tags + row * tagStride, tagStride) * kBalancedPreferredBonus;
+    };
     
-    double breakfastFat = user.getDailyFatGoal() * 0.3;
-    double lunchFat = user.getDailyFatGoal() * 0.4;
-    double dinnerFat = user.getDailyFatGoal() * 0.3;
+    std::vector<DailyPlanner::Slot> slots;
+    for (size_t m = 0; m < sizeof(kDailyMeals) / sizeof(kDailyMeals[0]); ++m) {
+        for (const TemplateSlot& templateSlot : templateFor(kDailyMeals[m].kind)) {
+            DailyPlanner::Slot slot;
+            slot.meal = m;
+            for (size_t row : categoryCandidates[templateSlot.categoryId]) {
+                if (excluded.intersects(tags + row * tagStride, tagStride)) continue;
+                slot.candidates.push_back({row, extraCost(row)});
+            }
+            slots.push_back(std::move(slot));
+        }
+    }
     
-    Meal breakfast = recommendMeal(user, "breakfast", breakfastCalories, 
-                                   breakfastProtein, breakfastCarbs, breakfastFat);
-    breakfast.setDate(date);
-    dailyMeals.push_back(breakfast);
+    DailyPlanner::Options options = plannerOptions;
+    options.timeBudgetMs = budgetMs;
+    if (mode == PlanMode::BalancedPortions) {
+        options.portions = {0.5, 1.0, 1.5, 2.0};
+    }
+    const ScoringKernel::Targets& goals = profile.dailyGoals;
     
-    Meal lunch = recommendMeal(user, "lunch", lunchCalories,
-                              lunchProtein, lunchCarbs, lunchFat);
-    lunch.setDate(date);
-    dailyMeals.push_back(lunch);
+    // 逐餐挑选的方案满足同样的约束时，以它的目标值作为初始上界
+    ScoringKernel::Targets totals = {0, 0, 0, 0};
+    double baselineCost = 0;
+    bool feasible = true;
+    std::vector<char> used(catalog->size(), 0);
+    for (const auto& meal : baseline) {
+        for (int foodId : meal.getFoodIds()) {
+            int row = catalog->indexOf(foodId);
+            if (row < 0 || excluded.intersects(tags + row * tagStride, tagStride) || (options.distinctFoods && used[row])) {
+                feasible = false;
+                break;
+            }
+            used[row] = 1;
+            baselineCost += extraCost(row);
+        }
+        totals.calories += meal.getTotalCalories();
+        totals.protein += meal.getTotalProtein();
+        totals.carbs += meal.getTotalCarbs();
+        totals.fat += meal.getTotalFat();
+    }
+    if (feasible) {
+        options.incumbent = DailyPlanner::deviation(totals, goals) + baselineCost;
+    }
     
-    Meal dinner = recommendMeal(user, "dinner", dinnerCalories,
-                               dinnerProtein, dinnerCarbs, dinnerFat);
-    dinner.setDate(date);
-    dailyMeals.push_back(dinner);
+    DailyPlanner::Result result = DailyPlanner::solve(*catalog, slots, goals, options);
+    complete = result.complete;
+    if (result.choices.empty()) {
+        return {};
+    }
     
+    std::vector<Meal> dailyMeals;
+    for (const MealShare& share : kDailyMeals) {
+        Meal meal(0, profile.userId, "", MealTemplates::nameOf(share.kind));
+        meal.setIsRecommended(true);
+        dailyMeals.push_back(meal);
+    }
+    for (size_t s = 0; s < slots.size(); ++s) {
+        const DailyPlanner::Choice& choice = result.choices[s];
+        if (choice.portion > 0) {
+            dailyMeals[slots[s].meal].addFood(catalog->getFoods()[choice.row], choice.portion);
+        }
+    }
     return dailyMeals;
 }
 
-std::vector<Food> RecommendationEngine::getAlternativeFoods(const Food& food, const User& user, int count) {
-    std::vector<std::pair<double, Food>> scoredFoods;
+std::vector<std::vector<std::vector<Meal>>> RecommendationEngine::recommendBatch(const std::vector<User>& users,
+                                                                                 const Date& from, int days,
+                                                                                 ThreadPool& pool) const {
+    const size_t mealCount = sizeof(kDailyMeals) / sizeof(kDailyMeals[0]);
+    // 每个用户一份可修改的历史，排好一天就把当天的推荐加进去；资料中的 history 指向它
+    std::vector<ScoringProfile> dayProfiles;
+    std::vector<std::shared_ptr<RecentFoodWindow>> histories;
+    dayProfiles.reserve(users.size());
+    histories.reserve(users.size());
+    for (const auto& user : users) {
+        dayProfiles.push_back(*profileFor(user));
+        histories.push_back(std::make_shared<RecentFoodWindow>(*dayProfiles.back().history));
+        dayProfiles.back().history = histories.back();
+    }
     
-    for (const auto& candidate : foodDatabase) {
-        if (candidate.getId() == food.getId()) continue;
+    std::vector<std::vector<std::vector<Meal>>> plans(users.size());
+    for (int dayIndex = 0; dayIndex < days; ++dayIndex) {
+        Date day = from.addDays(dayIndex);
+        // 同一天的各餐只读取前几天的历史，可以并行；当天全部完成后再加入历史
+        std::vector<std::future<Meal>> pending;
+        pending.reserve(users.size() * mealCount);
+        for (size_t u = 0; u < users.size(); ++u) {
+            for (size_t m = 0; m < mealCount; ++m) {
+                const ScoringProfile* profile = &dayProfiles[u];
+                const MealShare* share = &kDailyMeals[m];
+                pending.push_back(pool.submit([this, profile, share]() {
+                    return planMeal(*profile, share->kind,
+                                    profile->dailyGoals.calories * share->calories,
+                                    profile->dailyGoals.protein * share->protein,
+                                    profile->dailyGoals.carbs * share->carbs,
+                                    profile->dailyGoals.fat * share->fat);
+                }));
+            }
+        }
+        // 任务引用本函数的局部变量，即使有任务出错也要等全部结束再取结果
+        for (auto& task : pending) {
+            task.wait();
+        }
         
-        double score = calculateFoodScore(candidate, user, "alternative",
-                                         food.getCalories(), food.getProtein(),
-                                         food.getCarbohydrates(), food.getFat());
-        if (score > -500) {
-            scoredFoods.push_back({score, candidate});
+        for (size_t u = 0; u < users.size(); ++u) {
+            std::vector<Meal> dailyMeals;
+            for (size_t m = 0; m < mealCount; ++m) {
+                Meal meal = pending[u * mealCount + m].get();
+                meal.setDate(day);
+                histories[u]->add(meal);
+                dailyMeals.push_back(meal);
+            }
+            plans[u].push_back(dailyMeals);
         }
     }
     
-    std::sort(scoredFoods.begin(), scoredFoods.end(),
-             [](const auto& a, const auto& b) { return a.first > b.first; });
-    
+    return plans;
+}
+
+std::vector<std::vector<Meal>> RecommendationEngine::recommendDays(const User& user, const Date& from, int days,
+                                                                   ThreadPool& pool) const {
+    return recommendBatch({user}, from, days, pool)[0];
+}
+
+std::vector<Food> RecommendationEngine::getAlternativeFoods(const Food& food, const User& user, int count,
+                                                            bool sameCategory) {
     std::vector<Food> alternatives;
-    for (int i = 0; i < std::min(count, (int)scoredFoods.size()); ++i) {
-        alternatives.push_back(scoredFoods[i].second);
+    if (count <= 0) {
+        return alternatives;
+    }
+    const NutrientIndex* index = &nutrientIndex;
+    if (sameCategory) {
+        int categoryId = catalog->findCategory(food.getCategory());
+        if (categoryId < 0) {
+            return alternatives;
+        }
+        index = &categoryNutrientIndexes[categoryId];
+    }
+    
+    ScoringKernel::Targets targets = {food.getCalories(), food.getProtein(),
+                                      food.getCarbohydrates(), food.getFat()};
+    std::shared_ptr<const ScoringProfile> profile = profileFor(user);
+    const ScoringKernel::Preferences& preferences = profile->preferences;
+    
+    // 营养平衡分 = 权重之和 - 加权 L1 距离，因此距离为 d 的候选得分不超过 maxScore - d；
+    // 多样性项只会扣分。近邻按距离递增枚举，上界低于当前第 count 名时后面的候选都不可能入选。
+    // 距离和打分的浮点舍入不同，留出余量以免误停
+    const double targetValues[NutrientIndex::kDims] = {targets.calories, targets.protein,
+                                                       targets.carbs, targets.fat};
+    ScoringKernel::Targets nutritionWeights = ScoringKernel::nutritionWeights();
+    const double weightValues[NutrientIndex::kDims] = {nutritionWeights.calories, nutritionWeights.protein,
+                                                       nutritionWeights.carbs, nutritionWeights.fat};
+    double distanceWeights[NutrientIndex::kDims];
+    for (int d = 0; d < NutrientIndex::kDims; ++d) {
+        distanceWeights[d] = targetValues[d] > 0 ? weightValues[d] / targetValues[d] : 0.0;
+    }
+    const double maxScore = ScoringKernel::maxScore(preferences, targets);
+    const double slack = 1e-6;
+    
+    const int* ids = catalog->getIdColumn();
+    const uint64_t* tags = catalog->getTagColumn();
+    const int tagStride = catalog->getTagStride();
+    TopK<std::pair<double, size_t>, HigherScoreFirst> best(static_cast<size_t>(count));
+    index->forEachNearest(targetValues, distanceWeights, [&](size_t row, double distance) {
+        if (best.full() && maxScore - distance + slack < best.worst().first) {
+            return false;
+        }
+        if (ids[row] == food.getId() || preferences.allergens.intersects(tags + row * tagStride, tagStride)) {
+            return true;
+        }
+        double score;
+        ScoringKernel::scoreRows(*catalog, &row, 1, preferences, targets, &score);
+        score = applyDiversityPenalty(*profile->history, ids[row], score);
+        if (score > -500) {
+            best.push({score, row});
+        }
+        return true;
+    });
+    
+    for (const auto& scored : best.take()) {
+        alternatives.push_back(catalog->getFoods()[scored.second]);
     }
     
     return alternatives;
@@ -0,0 +1,383 @@
+#include "../include/ScoringKernel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SCORING_KERNEL_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 通过 target 属性单独为向量版本生成代码，其余代码仍按基础指令集编译；
+// MSVC 不需要额外开关即可使用这些内建函数。
+// 两档向量实现都要求 POPCNT：没有该指令时标签计数是函数调用，会抵消向量化的收益
+#if defined(SCORING_KERNEL_X86) && (defined(__GNUC__) || defined(_MSC_VER)) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SCORING_KERNEL_SIMD 1
+#if defined(__GNUC__)
+#define SCORING_KERNEL_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define SCORING_KERNEL_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#else
+#define SCORING_KERNEL_TARGET_SSE42
+#define SCORING_KERNEL_TARGET_AVX2
+#endif
+#endif
+
+namespace {
+
+// 营养平衡项的权重，顺序为 热量、蛋白质、碳水、脂肪
+const double kCalorieWeight = 20.0;
+const double kProteinWeight = 25.0;
+const double kCarbWeight = 15.0;
+const double kFatWeight = 10.0;
+
+// 一批候选行：rows 为空时是从列起点开始的连续行，否则按 rows 中的行号取值
+struct Block {
+    const double* calories;
+    const double* protein;
+    const double* carbs;
+    const double* fat;
+    const uint64_t* tags;   // 每行 tagStride 个字，见 FoodCatalog::getTagColumn
+    const size_t* rows;
+    size_t count;
+    int tagStride;
+    int tagWords;           // 标签项只需比较的字数，见 activeTagWords
+};
+
+using BlockKernel = void (*)(const Block&, const ScoringKernel::Preferences&,
+                             const ScoringKernel::Targets&, double*);
+
+// 目录只保存前 tagStride 个字，偏好掩码中最高的非零字之后也全为 0，
+// 标签项只需比较两者中较短的那部分，通常只有一个字
+int activeTagWords(const ScoringKernel::Preferences& preferences, int tagStride) {
+    TagMask merged = preferences.preferred | preferences.avoided | preferences.allergens;
+    int words = std::min(tagStride, TagMask::kWords);
+    while (words > 0 && merged.bits[words - 1] == 0) {
+        --words;
+    }
+    return words;
+}
+
+inline const uint64_t* tagsAt(const Block& block, size_t row) {
+    return block.tags + row * static_cast<size_t>(block.tagStride);
+}
+
+// 标签项需要 popcount，没有对应的向量指令，逐行计算
+inline double tagScore(const uint64_t* tags, const ScoringKernel::Preferences& preferences, int words) {
+    double score = 100.0;
+    score -= 50.0 * preferences.avoided.countShared(tags, words);
+    score += 30.0 * preferences.preferred.countShared(tags, words);
+    return score;
+}
+
+inline bool isExcluded(const uint64_t* tags, const ScoringKernel::Preferences& preferences, int words) {
+    return preferences.allergens.intersects(tags, words);
+}
+
+// 各实现都逐行计算 tagScore + ((0 + 热量项) + 蛋白质项 + 碳水项 + 脂肪项)，
+// 每项为 weight * (1 - |value / remaining - 1|)，运算顺序与这里的标量版本完全相同
+inline void scoreScalarRows(const Block& block, size_t begin,
+                            const ScoringKernel::Preferences& preferences,
+                            const ScoringKernel::Targets& targets, double* out) {
+    for (size_t i = begin; i < block.count; ++i) {
+        size_t row = block.rows ? block.rows[i] : i;
+        if (isExcluded(tagsAt(block, row), preferences, block.tagWords)) {
+            out[i] = ScoringKernel::kExcludedScore;
+            continue;
+        }
+        double nutritionScore = 0.0;
+        if (targets.calories > 0) {
+            nutritionScore += kCalorieWeight * (1.0 - std::abs(block.calories[row] / targets.calories - 1.0));
+        }
+        if (targets.protein > 0) {
+            nutritionScore += kProteinWeight * (1.0 - std::abs(block.protein[row] / targets.protein - 1.0));
+        }
+        if (targets.carbs > 0) {
+            nutritionScore += kCarbWeight * (1.0 - std::abs(block.carbs[row] / targets.carbs - 1.0));
+        }
+        if (targets.fat > 0) {
+            nutritionScore += kFatWeight * (1.0 - std::abs(block.fat[row] / targets.fat - 1.0));
+        }
+        out[i] = tagScore(tagsAt(block, row), preferences, block.tagWords) + nutritionScore;
+    }
+}
+
+void scoreScalar(const Block& block, const ScoringKernel::Preferences& preferences,
+                 const ScoringKernel::Targets& targets, double* out) {
+    scoreScalarRows(block, 0, preferences, targets, out);
+}
+
+#ifdef SCORING_KERNEL_SIMD
+template <bool Gathered>
+SCORING_KERNEL_TARGET_SSE42
+inline __m128d loadSse42(const double* column, const Block& block, size_t i) {
+    if (!Gathered) {
+        return _mm_loadu_pd(column + i);
+    }
+    return _mm_set_pd(column[block.rows[i + 1]], column[block.rows[i]]);
+}
+
+SCORING_KERNEL_TARGET_SSE42
+inline __m128d balanceTermSse42(__m128d value, double remaining, double weight) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    __m128d deviation = _mm_sub_pd(_mm_div_pd(value, _mm_set1_pd(remaining)), one);
+    return _mm_mul_pd(_mm_set1_pd(weight), _mm_sub_pd(one, _mm_andnot_pd(signMask, deviation)));
+}
+
+template <bool Gathered, bool SingleTagWord>
+SCORING_KERNEL_TARGET_SSE42
+void scoreSse42Block(const Block& block, const ScoringKernel::Preferences& preferences,
+                     const ScoringKernel::Targets& targets, double* out) {
+    // 目录和偏好的标签都只占一个字时，逐字循环在编译期消去
+    const int tagWords = SingleTagWord ? 1 : block.tagWords;
+    size_t i = 0;
+    for (; i + 2 <= block.count; i += 2) {
+        const uint64_t* tags0 = tagsAt(block, Gathered ? block.rows[i] : i);
+        const uint64_t* tags1 = tagsAt(block, Gathered ? block.rows[i + 1] : i + 1);
+        __m128d base = _mm_set_pd(tagScore(tags1, preferences, tagWords),
+                                  tagScore(tags0, preferences, tagWords));
+
+        __m128d nutritionScore = _mm_setzero_pd();
+        if (targets.calories > 0) {
+            nutritionScore = _mm_add_pd(nutritionScore,
+                balanceTermSse42(loadSse42<Gathered>(block.calories, block, i), targets.calories, kCalorieWeight));
+        }
+        if (targets.protein > 0) {
+            nutritionScore = _mm_add_pd(nutritionScore,
+                balanceTermSse42(loadSse42<Gathered>(block.protein, block, i), targets.protein, kProteinWeight));
+        }
+        if (targets.carbs > 0) {
+            nutritionScore = _mm_add_pd(nutritionScore,
+                balanceTermSse42(loadSse42<Gathered>(block.carbs, block, i), targets.carbs, kCarbWeight));
+        }
+        if (targets.fat > 0) {
+            nutritionScore = _mm_add_pd(nutritionScore,
+                balanceTermSse42(loadSse42<Gathered>(block.fat, block, i), targets.fat, kFatWeight));
+        }
+        _mm_storeu_pd(out + i, _mm_add_pd(base, nutritionScore));
+        if (isExcluded(tags0, preferences, tagWords)) out[i] = ScoringKernel::kExcludedScore;
+        if (isExcluded(tags1, preferences, tagWords)) out[i + 1] = ScoringKernel::kExcludedScore;
+    }
+    scoreScalarRows(block, i, preferences, targets, out);
+}
+
+SCORING_KERNEL_TARGET_SSE42
+void scoreSse42(const Block& block, const ScoringKernel::Preferences& preferences,
+                const ScoringKernel::Targets& targets, double* out) {
+    bool single = block.tagWords <= 1;
+    if (block.rows) {
+        if (single) {
+            scoreSse42Block<true, true>(block, preferences, targets, out);
+        } else {
+            scoreSse42Block<true, false>(block, preferences, targets, out);
+        }
+    } else {
+        if (single) {
+            scoreSse42Block<false, true>(block, preferences, targets, out);
+        } else {
+            scoreSse42Block<false, false>(block, preferences, targets, out);
+        }
+    }
+}
+
+template <bool Gathered>
+SCORING_KERNEL_TARGET_AVX2
+inline __m256d loadAvx2(const double* column, const Block& block, size_t i) {
+    if (!Gathered) {
+        return _mm256_loadu_pd(column + i);
+    }
+    // 实测 vgatherqpd 比四次标量加载慢，按行号取值时逐个装入
+    return _mm256_set_pd(column[block.rows[i + 3]], column[block.rows[i + 2]],
+                         column[block.rows[i + 1]], column[block.rows[i]]);
+}
+
+SCORING_KERNEL_TARGET_AVX2
+inline __m256d balanceTermAvx2(__m256d value, double remaining, double weight) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    __m256d deviation = _mm256_sub_pd(_mm256_div_pd(value, _mm256_set1_pd(remaining)), one);
+    return _mm256_mul_pd(_mm256_set1_pd(weight), _mm256_sub_pd(one, _mm256_andnot_pd(signMask, deviation)));
+}
+
+template <bool Gathered, bool SingleTagWord>
+SCORING_KERNEL_TARGET_AVX2
+void scoreAvx2Block(const Block& block, const ScoringKernel::Preferences& preferences,
+                    const ScoringKernel::Targets& targets, double* out) {
+    // 目录和偏好的标签都只占一个字时，逐字循环在编译期消去
+    const int tagWords = SingleTagWord ? 1 : block.tagWords;
+    size_t i = 0;
+    for (; i + 4 <= block.count; i += 4) {
+        alignas(32) double base[4];
+        bool excluded = false;
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const uint64_t* tags = tagsAt(block, Gathered ? block.rows[i + lane] : i + lane);
+            base[lane] = tagScore(tags, preferences, tagWords);
+            excluded |= isExcluded(tags, preferences, tagWords);
+        }
+
+        __m256d nutritionScore = _mm256_setzero_pd();
+        if (targets.calories > 0) {
+            nutritionScore = _mm256_add_pd(nutritionScore,
+                balanceTermAvx2(loadAvx2<Gathered>(block.calories, block, i), targets.calories, kCalorieWeight));
+        }
+        if (targets.protein > 0) {
+            nutritionScore = _mm256_add_pd(nutritionScore,
+                balanceTermAvx2(loadAvx2<Gathered>(block.protein, block, i), targets.protein, kProteinWeight));
+        }
+        if (targets.carbs > 0) {
+            nutritionScore = _mm256_add_pd(nutritionScore,
+                balanceTermAvx2(loadAvx2<Gathered>(block.carbs, block, i), targets.carbs, kCarbWeight));
+        }
+        if (targets.fat > 0) {
+            nutritionScore = _mm256_add_pd(nutritionScore,
+                balanceTermAvx2(loadAvx2<Gathered>(block.fat, block, i), targets.fat, kFatWeight));
+        }
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_load_pd(base), nutritionScore));
+        if (excluded) {
+            for (size_t lane = 0; lane < 4; ++lane) {
+                if (isExcluded(tagsAt(block, Gathered ? block.rows[i + lane] : i + lane), preferences, tagWords)) {
+                    out[i + lane] = ScoringKernel::kExcludedScore;
+                }
+            }
+        }
+    }
+    scoreScalarRows(block, i, preferences, targets, out);
+}
+
+SCORING_KERNEL_TARGET_AVX2
+void scoreAvx2(const Block& block, const ScoringKernel::Preferences& preferences,
+               const ScoringKernel::Targets& targets, double* out) {
+    bool single = block.tagWords <= 1;
+    if (block.rows) {
+        if (single) {
+            scoreAvx2Block<true, true>(block, preferences, targets, out);
+        } else {
+            scoreAvx2Block<true, false>(block, preferences, targets, out);
+        }
+    } else {
+        if (single) {
+            scoreAvx2Block<false, true>(block, preferences, targets, out);
+        } else {
+            scoreAvx2Block<false, false>(block, preferences, targets, out);
+        }
+    }
+}
+#endif
+
+BlockKernel kernelFor(ScoringKernel::Isa isa) {
+    switch (isa) {
+#ifdef SCORING_KERNEL_SIMD
+    case ScoringKernel::Isa::Avx2:
+        return scoreAvx2;
+    case ScoringKernel::Isa::Sse42:
+        return scoreSse42;
+#endif
+    default:
+        return scoreScalar;
+    }
+}
+
+std::atomic<int>& selectedIsa() {
+    static std::atomic<int> isa(static_cast<int>(ScoringKernel::detectIsa()));
+    return isa;
+}
+
+} // namespace
+
+void ScoringKernel::scoreRows(const FoodCatalog& catalog, const size_t* rows, size_t count,
+                              const Preferences& preferences, const Targets& targets,
+                              double* scores) {
+    if (count == 0) {
+        return;
+    }
+    Block block = {catalog.getCalorieColumn(), catalog.getProteinColumn(),
+                   catalog.getCarbColumn(), catalog.getFatColumn(),
+                   catalog.getTagColumn(), rows, count, catalog.getTagStride(),
+                   activeTagWords(preferences, catalog.getTagStride())};
+    kernelFor(getIsa())(block, preferences, targets, scores);
+}
+
+void ScoringKernel::scoreRange(const FoodCatalog& catalog, size_t begin, size_t end,
+                               const Preferences& preferences, const Targets& targets,
+                               double* scores) {
+    if (begin >= end) {
+        return;
+    }
+    // 连续行直接读取目录的列
+    Block block = {catalog.getCalorieColumn() + begin, catalog.getProteinColumn() + begin,
+                   catalog.getCarbColumn() + begin, catalog.getFatColumn() + begin,
+                   catalog.getTagColumn() + begin * catalog.getTagStride(), nullptr, end - begin,
+                   catalog.getTagStride(), activeTagWords(preferences, catalog.getTagStride())};
+    kernelFor(getIsa())(block, preferences, targets, scores);
+}
+
+ScoringKernel::Targets ScoringKernel::nutritionWeights() {
+    return {kCalorieWeight, kProteinWeight, kCarbWeight, kFatWeight};
+}
+
+double ScoringKernel::maxScore(const Preferences& preferences, const Targets& targets) {
+    double score = 100.0 + 30.0 * preferences.preferred.count();
+    if (targets.calories > 0) score += kCalorieWeight;
+    if (targets.protein > 0) score += kProteinWeight;
+    if (targets.carbs > 0) score += kCarbWeight;
+    if (targets.fat > 0) score += kFatWeight;
+    return score;
+}
+
+ScoringKernel::Isa ScoringKernel::detectIsa() {
+#if defined(SCORING_KERNEL_SIMD) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return Isa::Avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        return Isa::Sse42;
+    }
+#elif defined(SCORING_KERNEL_SIMD) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool hasSse42 = (info[2] & (1 << 20)) != 0;
+    bool hasPopcnt = (info[2] & (1 << 23)) != 0;
+    bool hasAvx = (info[2] & (1 << 28)) != 0;
+    bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    if (maxLeaf >= 7 && hasAvx && osSavesYmm && hasPopcnt) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) {
+            return Isa::Avx2;
+        }
+    }
+    if (hasSse42 && hasPopcnt) {
+        return Isa::Sse42;
+    }
+#endif
+    return Isa::Scalar;
+}
+
+ScoringKernel::Isa ScoringKernel::getIsa() {
+    return static_cast<Isa>(selectedIsa().load(std::memory_order_relaxed));
+}
+
+void ScoringKernel::setIsa(Isa isa) {
+    Isa supported = detectIsa();
+    if (static_cast<int>(isa) > static_cast<int>(supported)) {
+        isa = supported;
+    }
+    selectedIsa().store(static_cast<int>(isa), std::memory_order_relaxed);
+}
+
+const char* ScoringKernel::isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Avx2:
+        return "AVX2";
+    case Isa::Sse42:
+        return "SSE4.2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,446 @@
+#include "../include/SnapshotFile.h"
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <set>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 所有记录按 8 字节对齐，映射后可以直接按结构体读取
+struct StrRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct RangeRef {
+    uint32_t begin;
+    uint32_t count;
+};
+
+struct SectionRef {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct FoodRecord {
+    int32_t id;
+    uint32_t reserved;
+    StrRef name;
+    StrRef category;
+    RangeRef tags;
+    double calories;
+    double protein;
+    double carbohydrates;
+    double fat;
+    double fiber;
+};
+
+struct UserRecord {
+    int32_t id;
+    int32_t age;
+    StrRef username;
+    StrRef password;
+    StrRef gender;
+    StrRef activityLevel;
+    RangeRef preferredTags;
+    RangeRef avoidedTags;
+    RangeRef allergens;
+    double weight;
+    double height;
+    double dailyCalorieGoal;
+    double dailyProteinGoal;
+    double dailyCarbGoal;
+    double dailyFatGoal;
+};
+
+struct MealRecord {
+    int32_t id;
+    int32_t userId;
+    int32_t date;           // Date::toDays()
+    uint32_t reserved0;
+    StrRef mealType;
+    RangeRef foods;
+    uint32_t isRecommended;
+    uint32_t reserved;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    SnapshotFile::SourceStamp stamps[3];
+    SectionRef users;
+    SectionRef foods;
+    SectionRef meals;
+    SectionRef tagRefs;     // StrRef 数组，标签集合通过 RangeRef 引用
+    SectionRef foodIds;     // int32 数组，餐单中的食物ID
+    SectionRef portions;    // double 数组，与 foodIds 一一对应的份数
+    SectionRef strings;     // 字符串表，count 为字节数
+};
+
+static_assert(sizeof(FoodRecord) == 72, "FoodRecord layout changed");
+static_assert(sizeof(UserRecord) == 112, "UserRecord layout changed");
+static_assert(sizeof(MealRecord) == 40, "MealRecord layout changed");
+static_assert(sizeof(Header) % 8 == 0, "Header must keep 8-byte alignment");
+
+const char kMagic[8] = {'S', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+class Builder {
+private:
+    std::string strings;
+    std::vector<StrRef> tagRefs;
+
+public:
+    std::vector<int32_t> foodIds;
+    std::vector<double> portions;
+
+    StrRef addString(const std::string& str) {
+        StrRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(str.size())};
+        strings += str;
+        return ref;
+    }
+
+    RangeRef addTags(const std::set<std::string>& tags) {
+        RangeRef range{static_cast<uint32_t>(tagRefs.size()), static_cast<uint32_t>(tags.size())};
+        for (const auto& tag : tags) {
+            tagRefs.push_back(addString(tag));
+        }
+        return range;
+    }
+
+    const std::string& getStrings() const { return strings; }
+    const std::vector<StrRef>& getTagRefs() const { return tagRefs; }
+};
+
+template <typename T>
+SectionRef appendSection(std::string& buffer, const T* items, size_t count) {
+    // 每个分区起点按 8 字节对齐
+    buffer.resize((buffer.size() + 7) & ~static_cast<size_t>(7), '\0');
+    SectionRef ref{buffer.size(), count};
+    buffer.append(reinterpret_cast<const char*>(items), count * sizeof(T));
+    return ref;
+}
+
+std::string readString(const char* data, const Header* header, const StrRef& ref) {
+    return std::string(data + header->strings.offset + ref.offset, ref.length);
+}
+
+std::set<std::string> readTags(const char* data, const Header* header, const RangeRef& range) {
+    const StrRef* refs = reinterpret_cast<const StrRef*>(data + header->tagRefs.offset);
+    std::set<std::string> tags;
+    for (uint32_t i = 0; i < range.count; ++i) {
+        tags.insert(readString(data, header, refs[range.begin + i]));
+    }
+    return tags;
+}
+
+}
+
+SnapshotFile::SourceStamp SnapshotFile::stampOf(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    SourceStamp stamp{0, 0};
+    auto size = fs::file_size(path, ec);
+    if (ec) return stamp;
+    auto mtime = fs::last_write_time(path, ec);
+    if (ec) return stamp;
+    stamp.size = size;
+    stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return stamp;
+}
+
+std::string SnapshotFile::build(const std::vector<User>& users,
+                                const std::vector<Food>& foods,
+                                const std::vector<Meal>& meals,
+                                const SourceStamp& usersStamp,
+                                const SourceStamp& foodsStamp) {
+    Builder builder;
+
+    std::vector<UserRecord> userRecords;
+    userRecords.reserve(users.size());
+    for (const auto& user : users) {
+        UserRecord rec{};
+        rec.id = user.getId();
+        rec.age = user.getAge();
+        rec.username = builder.addString(user.getUsername());
+        rec.password = builder.addString(user.getPassword());
+        rec.gender = builder.addString(user.getGender());
+        rec.activityLevel = builder.addString(user.getActivityLevel());
+        rec.preferredTags = builder.addTags(user.getPreferredTags());
+        rec.avoidedTags = builder.addTags(user.getAvoidedTags());
+        rec.allergens = builder.addTags(user.getAllergens());
+        rec.weight = user.getWeight();
+        rec.height = user.getHeight();
+        rec.dailyCalorieGoal = user.getDailyCalorieGoal();
+        rec.dailyProteinGoal = user.getDailyProteinGoal();
+        rec.dailyCarbGoal = user.getDailyCarbGoal();
+        rec.dailyFatGoal = user.getDailyFatGoal();
+        userRecords.push_back(rec);
+    }
+
+    std::vector<FoodRecord> foodRecords;
+    foodRecords.reserve(foods.size());
+    for (const auto& food : foods) {
+        FoodRecord rec{};
+        rec.id = food.getId();
+        rec.name = builder.addString(food.getName());
+        rec.category = builder.addString(food.getCategory());
+        rec.tags = builder.addTags(food.getTags());
+        rec.calories = food.getCalories();
+        rec.protein = food.getProtein();
+        rec.carbohydrates = food.getCarbohydrates();
+        rec.fat = food.getFat();
+        rec.fiber = food.getFiber();
+        foodRecords.push_back(rec);
+    }
+
+    std::vector<MealRecord> mealRecords;
+    mealRecords.reserve(meals.size());
+    for (const auto& meal : meals) {
+        MealRecord rec{};
+        rec.id = meal.getId();
+        rec.userId = meal.getUserId();
+        rec.date = meal.getDay().toDays();
+        rec.mealType = builder.addString(meal.getMealType());
+        rec.isRecommended = meal.getIsRecommended() ? 1 : 0;
+        const auto& mealFoods = meal.getFoodIds();
+        rec.foods.begin = static_cast<uint32_t>(builder.foodIds.size());
+        rec.foods.count = static_cast<uint32_t>(mealFoods.size());
+        builder.foodIds.insert(builder.foodIds.end(), mealFoods.begin(), mealFoods.end());
+        builder.portions.insert(builder.portions.end(), meal.getPortions().begin(), meal.getPortions().end());
+        mealRecords.push_back(rec);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(Header);
+    header.stamps[UsersSection] = usersStamp;
+    header.stamps[FoodsSection] = foodsStamp;
+    header.stamps[MealsSection] = SourceStamp{0, 0};
+
+    std::string buffer(sizeof(Header), '\0');
+    header.users = appendSection(buffer, userRecords.data(), userRecords.size());
+    header.foods = appendSection(buffer, foodRecords.data(), foodRecords.size());
+    header.meals = appendSection(buffer, mealRecords.data(), mealRecords.size());
+    header.tagRefs = appendSection(buffer, builder.getTagRefs().data(), builder.getTagRefs().size());
+    header.foodIds = appendSection(buffer, builder.foodIds.data(), builder.foodIds.size());
+    header.portions = appendSection(buffer, builder.portions.data(), builder.portions.size());
+    header.strings = appendSection(buffer, builder.getStrings().data(), builder.getStrings().size());
+    std::memcpy(&buffer[0], &header, sizeof(Header));
+    return buffer;
+}
+
+void SnapshotFile::patchStamp(std::string& buffer, Section section, const SourceStamp& stamp) {
+    if (buffer.size() < sizeof(Header)) return;
+    std::memcpy(&buffer[offsetof(Header, stamps) + section * sizeof(SourceStamp)], &stamp, sizeof(SourceStamp));
+}
+
+SnapshotFile::SnapshotFile() : data(nullptr), size(0),
+#ifdef _WIN32
+    fileHandle(nullptr), mappingHandle(nullptr)
+#else
+    fd(-1)
+#endif
+{}
+
+SnapshotFile::~SnapshotFile() {
+    close();
+}
+
+bool SnapshotFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const char*>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat st;
+    if (fstat(file, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(file);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+        ::close(file);
+        return false;
+    }
+    fd = file;
+    data = static_cast<const char*>(view);
+    size = static_cast<size_t>(st.st_size);
+#endif
+
+    if (!validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SnapshotFile::close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data) munmap(const_cast<char*>(data), size);
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool SnapshotFile::validate() const {
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) return false;
+    if (header->version != kVersion || header->headerSize != sizeof(Header)) return false;
+
+    auto fits = [this](const SectionRef& section, size_t itemSize) {
+        return section.offset % 8 == 0 && section.offset <= size &&
+               section.count <= (size - section.offset) / itemSize;
+    };
+    if (!fits(header->users, sizeof(UserRecord)) || !fits(header->foods, sizeof(FoodRecord)) ||
+        !fits(header->meals, sizeof(MealRecord)) || !fits(header->tagRefs, sizeof(StrRef)) ||
+        !fits(header->foodIds, sizeof(int32_t)) || !fits(header->portions, sizeof(double)) ||
+        !fits(header->strings, 1) || header->portions.count != header->foodIds.count) {
+        return false;
+    }
+
+    // 校验所有引用都落在对应分区内，损坏的快照直接放弃
+    auto strOk = [header](const StrRef& ref) {
+        return static_cast<uint64_t>(ref.offset) + ref.length <= header->strings.count;
+    };
+    auto tagsOk = [header](const RangeRef& range) {
+        return static_cast<uint64_t>(range.begin) + range.count <= header->tagRefs.count;
+    };
+    const StrRef* tagRefs = reinterpret_cast<const StrRef*>(data + header->tagRefs.offset);
+    for (uint64_t i = 0; i < header->tagRefs.count; ++i) {
+        if (!strOk(tagRefs[i])) return false;
+    }
+    const UserRecord* users = reinterpret_cast<const UserRecord*>(data + header->users.offset);
+    for (uint64_t i = 0; i < header->users.count; ++i) {
+        const auto& rec = users[i];
+        if (!strOk(rec.username) || !strOk(rec.password) || !strOk(rec.gender) ||
+            !strOk(rec.activityLevel) || !tagsOk(rec.preferredTags) ||
+            !tagsOk(rec.avoidedTags) || !tagsOk(rec.allergens)) {
+            return false;
+        }
+    }
+    const FoodRecord* foods = reinterpret_cast<const FoodRecord*>(data + header->foods.offset);
+    for (uint64_t i = 0; i < header->foods.count; ++i) {
+        if (!strOk(foods[i].name) || !strOk(foods[i].category) || !tagsOk(foods[i].tags)) return false;
+    }
+    const MealRecord* meals = reinterpret_cast<const MealRecord*>(data + header->meals.offset);
+    for (uint64_t i = 0; i < header->meals.count; ++i) {
+        const auto& rec = meals[i];
+        if (!strOk(rec.mealType) ||
+            static_cast<uint64_t>(rec.foods.begin) + rec.foods.count > header->foodIds.count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SnapshotFile::isFresh(Section section, const std::string& textFile) const {
+    if (!data) return false;
+    const Header* header = reinterpret_cast<const Header*>(data);
+    SourceStamp current = stampOf(textFile);
+    const SourceStamp& recorded = header->stamps[section];
+    return recorded.size == current.size && recorded.mtime == current.mtime;
+}
+
+void SnapshotFile::decodeUsers(std::vector<User>& users) const {
+    const Header* header = reinterpret_cast<const Header*>(data);
+    const UserRecord* records = reinterpret_cast<const UserRecord*>(data + header->users.offset);
+    users.clear();
+    users.reserve(header->users.count);
+    for (uint64_t i = 0; i < header->users.count; ++i) {
+        const auto& rec = records[i];
+        User user(rec.id, readString(data, header, rec.username), readString(data, header, rec.password));
+        user.setAge(rec.age);
+        user.setWeight(rec.weight);
+        user.setHeight(rec.height);
+        user.setGender(readString(data, header, rec.gender));
+        user.setActivityLevel(readString(data, header, rec.activityLevel));
+        user.setDailyCalorieGoal(rec.dailyCalorieGoal);
+        user.setDailyProteinGoal(rec.dailyProteinGoal);
+        user.setDailyCarbGoal(rec.dailyCarbGoal);
+        user.setDailyFatGoal(rec.dailyFatGoal);
+        for (const auto& tag : readTags(data, header, rec.preferredTags)) user.addPreferredTag(tag);
+        for (const auto& tag : readTags(data, header, rec.avoidedTags)) user.addAvoidedTag(tag);
+        for (const auto& tag : readTags(data, header, rec.allergens)) user.addAllergen(tag);
+        users.push_back(user);
+    }
+}
+
+void SnapshotFile::decodeFoods(std::vector<Food>& foods) const {
+    const Header* header = reinterpret_cast<const Header*>(data);
+    const FoodRecord* records = reinterpret_cast<const FoodRecord*>(data + header->foods.offset);
+    foods.clear();
+    foods.reserve(header->foods.count);
+    for (uint64_t i = 0; i < header->foods.count; ++i) {
+        const auto& rec = records[i];
+        foods.emplace_back(rec.id, readString(data, header, rec.name), rec.calories, rec.protein,
+                           rec.carbohydrates, rec.fat, rec.fiber,
+                           readTags(data, header, rec.tags), readString(data, header, rec.category));
+    }
+}
+
+void SnapshotFile::decodeMeals(std::vector<Meal>& meals,
+                               const std::function<const Food*(int)>& findFood) const {
+    const Header* header = reinterpret_cast<const Header*>(data);
+    const MealRecord* records = reinterpret_cast<const MealRecord*>(data + header->meals.offset);
+    const int32_t* foodIds = reinterpret_cast<const int32_t*>(data + header->foodIds.offset);
+    const double* portions = reinterpret_cast<const double*>(data + header->portions.offset);
+    meals.clear();
+    meals.reserve(header->meals.count);
+    for (uint64_t i = 0; i < header->meals.count; ++i) {
+        const auto& rec = records[i];
+        Meal meal(rec.id, rec.userId, Date::fromDays(rec.date), readString(data, header, rec.mealType));
+        meal.setIsRecommended(rec.isRecommended != 0);
+        for (uint32_t j = 0; j < rec.foods.count; ++j) {
+            const Food* food = findFood(foodIds[rec.foods.begin + j]);
+            if (food) {
+                meal.addFood(*food, portions[rec.foods.begin + j]);
+            }
+        }
+        meals.push_back(std::move(meal));
+    }
+}
@@ -0,0 +1,70 @@
+#include "../include/TagDictionary.h"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+TagDictionary& TagDictionary::instance() {
+    static TagDictionary dictionary;
+    return dictionary;
+}
+
+int TagDictionary::intern(std::string_view tag) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(tag);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(tag);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    if (names.size() >= static_cast<size_t>(TagMask::kBits)) {
+        // 忽略标签会让它在下次保存时从用户和食物中消失，过敏源过滤也随之失效
+        throw std::length_error("tag dictionary is full (" + std::to_string(TagMask::kBits) +
+                                " distinct tags), cannot add tag: " + std::string(tag));
+    }
+    int id = static_cast<int>(names.size());
+    names.emplace_back(tag);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+int TagDictionary::find(std::string_view tag) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(tag);
+    return it == ids.end() ? -1 : it->second;
+}
+
+TagMask TagDictionary::toMask(const std::set<std::string>& tags) {
+    TagMask mask;
+    for (const auto& tag : tags) {
+        mask.set(intern(tag));
+    }
+    return mask;
+}
+
+std::vector<std::string> TagDictionary::toNames(const TagMask& mask) const {
+    std::vector<std::string> result;
+    if (mask.empty()) {
+        return result;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (size_t id = 0; id < names.size(); ++id) {
+            if (mask.test(static_cast<int>(id))) {
+                result.push_back(names[id]);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::set<std::string> TagDictionary::toSet(const TagMask& mask) const {
+    std::vector<std::string> sorted = toNames(mask);
+    return std::set<std::string>(sorted.begin(), sorted.end());
+}
@@ -0,0 +1,89 @@
+#include "../include/TextParser.h"
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <cctype>
+
+bool TextParser::LineReader::next(std::string_view& line) {
+    if (pos >= buffer.size()) {
+        return false;
+    }
+    size_t end = buffer.find('\n', pos);
+    if (end == std::string_view::npos) {
+        end = buffer.size();
+    }
+    line = buffer.substr(pos, end - pos);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    pos = end + 1;
+    return true;
+}
+
+bool TextParser::readFile(const std::string& path, std::string& buffer) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    buffer.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    if (!buffer.empty()) {
+        file.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+        buffer.resize(static_cast<size_t>(file.gcount()));
+    }
+    return true;
+}
+
+size_t TextParser::split(std::string_view str, char delimiter, std::vector<std::string_view>& fields) {
+    fields.clear();
+    size_t start = 0;
+    while (start < str.size()) {
+        size_t end = str.find(delimiter, start);
+        if (end == std::string_view::npos) {
+            fields.push_back(str.substr(start));
+            break;
+        }
+        fields.push_back(str.substr(start, end - start));
+        start = end + 1;
+    }
+    return fields.size();
+}
+
+namespace {
+std::string_view skipLeadingSpace(std::string_view str) {
+    size_t i = 0;
+    while (i < str.size() && std::isspace(static_cast<unsigned char>(str[i]))) ++i;
+    str.remove_prefix(i);
+    // from_chars 不接受 '+'，std::stoi 接受
+    if (str.size() > 1 && str[0] == '+' && str[1] != '-') str.remove_prefix(1);
+    return str;
+}
+}
+
+int TextParser::toInt(std::string_view str) {
+    str = skipLeadingSpace(str);
+    int value = 0;
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec == std::errc::result_out_of_range) {
+        throw std::out_of_range("integer out of range: " + std::string(str));
+    }
+    if (result.ec != std::errc()) {
+        throw std::invalid_argument("invalid integer: " + std::string(str));
+    }
+    return value;
+}
+
+double TextParser::toDouble(std::string_view str) {
+    str = skipLeadingSpace(str);
+    double value = 0.0;
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec == std::errc::result_out_of_range) {
+        throw std::out_of_range("number out of range: " + std::string(str));
+    }
+    if (result.ec != std::errc()) {
+        throw std::invalid_argument("invalid number: " + std::string(str));
+    }
+    return value;
+}
@@ -0,0 +1,97 @@
+#include "../include/ThreadPool.h"
+
+namespace {
+
+// 当前线程所属的线程池和队列编号，用于把工作线程内部提交的任务放回自己的队列
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentQueue = 0;
+
+}
+
+ThreadPool::ThreadPool(size_t threadCount) : nextQueue(0), pending(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+    queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    // 先计数再入队，取走任务时的递减不会先于这里的递增
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++pending;
+    }
+    if (currentPool == this) {
+        WorkerQueue& own = *queues[currentQueue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_front(std::move(task));
+    } else {
+        WorkerQueue& target = *queues[nextQueue.fetch_add(1) % queues.size()];
+        std::lock_guard<std::mutex> lock(target.mutex);
+        target.tasks.push_back(std::move(task));
+    }
+    cv.notify_one();
+}
+
+bool ThreadPool::tryPop(size_t index, std::function<void()>& task) {
+    {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            --pending;
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkerQueue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            --pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentQueue = index;
+    while (true) {
+        std::function<void()> task;
+        if (tryPop(index, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        cv.wait(lock, [this] { return stopping || pending > 0; });
+        // 停止时先把队列中已提交的任务执行完
+        if (stopping && pending == 0) {
+            return;
+        }
+    }
+}
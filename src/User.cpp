@@ -15,28 +15,39 @@ User::User(int id, const std::string& username, const std::string& password)
       dailyCalorieGoal(2000), dailyProteinGoal(50), 
       dailyCarbGoal(250), dailyFatGoal(65) {}
 
+namespace {
+void addTag(TagMask& mask, const std::string& tag) {
+    mask.set(TagDictionary::instance().intern(tag));
+}
+
+void removeTag(TagMask& mask, const std::string& tag) {
+    int tagId = TagDictionary::instance().find(tag);
+    if (tagId >= 0) mask.reset(tagId);
+}
+}
+
 void User::addPreferredTag(const std::string& tag) {
-    preferredTags.insert(tag);
+    addTag(preferredTags, tag);
 }
 
 void User::addAvoidedTag(const std::string& tag) {
-    avoidedTags.insert(tag);
+    addTag(avoidedTags, tag);
 }
 
 void User::addAllergen(const std::string& allergen) {
-    allergens.insert(allergen);
+    addTag(allergens, allergen);
 }
 
 void User::removePreferredTag(const std::string& tag) {
-    preferredTags.erase(tag);
+    removeTag(preferredTags, tag);
 }
 
 void User::removeAvoidedTag(const std::string& tag) {
-    avoidedTags.erase(tag);
+    removeTag(avoidedTags, tag);
 }
 
 void User::removeAllergen(const std::string& allergen) {
-    allergens.erase(allergen);
+    removeTag(allergens, allergen);
 }
 
 void User::calculateNutritionGoals() {
@@ -82,7 +93,7 @@ void User::displayProfile() const {
          std::cout << u8"  喜欢的口味: ";
          std::stringstream ss;
          bool first = true;
-         for (const auto& tag : preferredTags) {
+         for (const auto& tag : TagDictionary::instance().toNames(preferredTags)) {
              if (!first) ss << u8", ";
              ss << tag;
              first = false;
@@ -94,7 +105,7 @@ void User::displayProfile() const {
          std::cout << u8"  避免的口味: ";
          std::stringstream ss;
          bool first = true;
-         for (const auto& tag : avoidedTags) {
+         for (const auto& tag : TagDictionary::instance().toNames(avoidedTags)) {
              if (!first) ss << u8", ";
              ss << tag;
              first = false;
@@ -112,8 +123,9 @@ std::string User::toString() const {
        << dailyCalorieGoal << "|" << dailyProteinGoal << "|" 
        << dailyCarbGoal << "|" << dailyFatGoal << "|";
     
+    const TagDictionary& dictionary = TagDictionary::instance();
     bool first = true;
-    for (const auto& tag : preferredTags) {
+    for (const auto& tag : dictionary.toNames(preferredTags)) {
         if (!first) ss << ",";
         ss << tag;
         first = false;
@@ -121,7 +133,7 @@ std::string User::toString() const {
     ss << "|";
     
     first = true;
-    for (const auto& tag : avoidedTags) {
+    for (const auto& tag : dictionary.toNames(avoidedTags)) {
         if (!first) ss << ",";
         ss << tag;
         first = false;
@@ -129,7 +141,7 @@ std::string User::toString() const {
     ss << "|";
     
     first = true;
-    for (const auto& allergen : allergens) {
+    for (const auto& allergen : dictionary.toNames(allergens)) {
         if (!first) ss << ",";
         ss << allergen;
         first = false;
@@ -1,5 +1,6 @@
 #include "../include/WebServer.h"
 #include "../include/third_party/httplib.h"
+#include "../include/TextParser.h"
 #include <iostream>
 #include <sstream>
 #include <random>
@@ -7,6 +8,7 @@
 #include <algorithm>
 #include <thread>
 #include <chrono>
+#include <csignal>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -15,18 +17,94 @@
 #include <cstdlib>
 #endif
 
-WebServer::WebServer(int port, const std::string& wwwRoot) 
-    : port(port), wwwRoot(wwwRoot) {
-    db = Database("data/users.txt", "data/foods.txt", "data/meals.txt");
-    
+namespace {
+// Ctrl+C 时让 listen 返回，析构 Database 时写出后台线程尚未落盘的变更。
+// 信号处理函数里只能做异步信号安全的操作，因此只置位标志，由 start() 中的线程调用 stop()
+std::atomic<bool> stopRequested(false);
+static_assert(std::atomic<bool>::is_always_lock_free, "stopRequested must be usable from a signal handler");
+
+void handleStopSignal(int) {
+    stopRequested = true;
+}
+
+// 历史餐单分页：单页条数上限，以及 "YYYY-MM-DD:mealId" 形式的游标
+const int kMaxHistoryPageSize = 500;
+
+// 批量推荐：一次最多排的天数
+const int kMaxPlanDays = 31;
+
+// 替代食物：一次最多返回的数量
+const int kMaxAlternatives = 50;
+
+// 请求中的 "mode"：缺省或 "greedy" 为逐餐挑选，"balanced" 为全天联合配餐，
+// "balanced-portions" 为联合配餐并调整份数
+bool parsePlanMode(const std::string& str, PlanMode& mode) {
+    if (str.empty() || str == "greedy") {
+        mode = PlanMode::Greedy;
+    } else if (str == "balanced") {
+        mode = PlanMode::Balanced;
+    } else if (str == "balanced-portions") {
+        mode = PlanMode::BalancedPortions;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 每日推荐的时间预算上限（毫秒），请求中的 budgetMs 超出时按上限处理
+const int kMaxPlanBudgetMs = 1000;
+
+// 作用域内把计数加一，离开时减一
+class ScopedCount {
+private:
+    std::atomic<int>& count;
+    int value;
+
+public:
+    explicit ScopedCount(std::atomic<int>& count) : count(count), value(++count) {}
+    ~ScopedCount() { --count; }
+    int get() const { return value; }
+};
+
+std::string formatMealCursor(const MealCursor& cursor) {
+    return cursor.date.toString() + ":" + std::to_string(cursor.mealId);
+}
+
+std::optional<MealCursor> parseMealCursor(const std::string& str) {
+    size_t sep = str.find(':');
+    if (sep == std::string::npos) {
+        return std::nullopt;
+    }
+    auto date = Date::parse(std::string_view(str).substr(0, sep));
+    if (!date) {
+        return std::nullopt;
+    }
+    try {
+        return MealCursor{*date, TextParser::toInt(std::string_view(str).substr(sep + 1))};
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+}
+
+WebServer::WebServer(int port, const std::string& wwwRoot, const PersistPolicy& persistPolicy)
+    : db("data/users.txt", "data/foods.txt", "data/meals.txt"),
+      activePlans(0), port(port), wwwRoot(wwwRoot) {
     if (!db.loadFoods()) {
         std::cout << u8"首次运行，初始化数据..." << std::endl;
         db.initializeSampleData();
     }
     db.loadUsers();
     db.loadMeals();
+    db.setPersistPolicy(persistPolicy);
     
-    engine.setFoodDatabase(db.getAllFoods());
+    engine.setFoodCatalog(db.getFoodCatalog());
+    // 可选的餐食模板覆盖，没有该文件时使用内置模板
+    MealTemplates templates;
+    if (templates.loadFile("data/meal_templates.txt")) {
+        std::cout << u8"已加载餐食模板: data/meal_templates.txt" << std::endl;
+    }
+    engine.setMealTemplates(templates);
     reloadEngineHistory();
 }
 
@@ -42,13 +120,17 @@ std::string WebServer::generateSessionToken() {
     return ss.str();
 }
 
-std::string WebServer::createJsonResponse(bool success, const std::string& message, const std::string& data) {
+std::string WebServer::createJsonResponse(bool success, const std::string& message, const std::string& data,
+                                          const std::string& extraFields) {
     std::stringstream ss;
     ss << "{\"success\":" << (success ? "true" : "false")
        << ",\"message\":\"" << message << "\"";
     if (!data.empty()) {
         ss << ",\"data\":" << data;
     }
+    if (!extraFields.empty()) {
+        ss << "," << extraFields;
+    }
     ss << "}";
     return ss.str();
 }
@@ -136,6 +218,41 @@ double WebServer::parseJsonDouble(const std::string& json, const std::string& ke
     return 0.0;
 }
 
+bool WebServer::parseJsonIntArray(const std::string& json, const std::string& key, std::vector<int>& values) {
+    values.clear();
+    std::string searchKey = "\"" + key + "\"";
+    size_t pos = json.find(searchKey);
+    if (pos == std::string::npos) return true;
+    
+    pos = json.find(":", pos);
+    if (pos == std::string::npos) return false;
+    pos++;
+    while (pos < json.length() && std::isspace(json[pos])) pos++;
+    if (pos >= json.length() || json[pos] != '[') return false;
+    
+    size_t endPos = json.find("]", pos);
+    if (endPos == std::string::npos) return false;
+    
+    std::string_view items(json.data() + pos + 1, endPos - pos - 1);
+    if (items.find_first_not_of("0123456789-, \t\r\n") != std::string_view::npos) return false;
+    
+    std::vector<std::string_view> fields;
+    TextParser::split(items, ',', fields);
+    for (std::string_view field : fields) {
+        if (field.find_first_not_of(" \t\r\n") == std::string_view::npos) {
+            // 只有 "[ ]" 这样的空数组允许出现空项
+            if (fields.size() == 1) break;
+            return false;
+        }
+        try {
+            values.push_back(TextParser::toInt(field));
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
 std::string WebServer::userToJson(const User& user) {
     std::stringstream ss;
     ss << std::fixed << std::setprecision(1);
@@ -155,7 +272,7 @@ std::string WebServer::userToJson(const User& user) {
     return ss.str();
 }
 
-std::string WebServer::foodToJson(const Food& food) {
+std::string WebServer::foodToJson(const Food& food, const std::string& extraFields) {
     std::stringstream ss;
     ss << std::fixed << std::setprecision(1);
     ss << "{"
@@ -168,18 +285,22 @@ std::string WebServer::foodToJson(const Food& food) {
        << "\"fat\":" << food.getFat() << ","
        << "\"tags\":[";
     
-    const auto& tags = food.getTags();
+    const auto tags = TagDictionary::instance().toNames(food.getTagMask());
     bool first = true;
     for (const auto& tag : tags) {
         if (!first) ss << ",";
         ss << "\"" << tag << "\"";
         first = false;
     }
-    ss << "]}";
+    ss << "]";
+    if (!extraFields.empty()) {
+        ss << "," << extraFields;
+    }
+    ss << "}";
     return ss.str();
 }
 
-std::string WebServer::mealToJson(const Meal& meal) {
+std::string WebServer::mealToJson(const Meal& meal, const FoodCatalog& catalog) {
     std::stringstream ss;
     ss << std::fixed << std::setprecision(1);
     ss << "{"
@@ -193,11 +314,17 @@ std::string WebServer::mealToJson(const Meal& meal) {
        << "\"totalFat\":" << meal.getTotalFat() << ","
        << "\"foods\":[";
     
-    const auto& foods = meal.getFoods();
+    // 目录中已不存在的食物被跳过
+    const auto& foodIds = meal.getFoodIds();
+    const auto& portions = meal.getPortions();
     bool first = true;
-    for (const auto& food : foods) {
+    for (size_t i = 0; i < foodIds.size(); ++i) {
+        const Food* food = catalog.find(foodIds[i]);
+        if (!food) continue;
         if (!first) ss << ",";
-        ss << foodToJson(food);
+        std::stringstream portion;
+        portion << std::fixed << std::setprecision(1) << "\"portion\":" << portions[i];
+        ss << foodToJson(*food, portion.str());
         first = false;
     }
     ss << "]}";
@@ -218,12 +345,14 @@ std::string WebServer::foodsArrayToJson(const std::vector<Food>& foods) {
 }
 
 std::string WebServer::mealsArrayToJson(const std::vector<Meal>& meals) {
+    // 整个数组用同一份目录快照解析食物
+    auto catalog = db.getFoodCatalog();
     std::stringstream ss;
     ss << "[";
     bool first = true;
     for (const auto& meal : meals) {
         if (!first) ss << ",";
-        ss << mealToJson(meal);
+        ss << mealToJson(meal, *catalog);
         first = false;
     }
     ss << "]";
@@ -232,12 +361,32 @@ std::string WebServer::mealsArrayToJson(const std::vector<Meal>& meals) {
 
 void WebServer::reloadEngineHistory() {
     std::map<int, std::vector<Meal>> allHistory;
-    for (const auto& meal : db.getAllMeals()) {
+    db.forEachMeal([&allHistory](const Meal& meal) {
         allHistory[meal.getUserId()].push_back(meal);
-    }
+    });
     engine.loadHistory(allHistory);
 }
 
+PlanResult WebServer::dailyPlan(const User& user, const Date& day, const std::string& date, PlanMode mode,
+                               int budgetMs, bool reuseTruncated) {
+    // 先取版本再生成：生成期间历史若有变化，存入的项版本已过期，不会被误用
+    PlanInputs inputs = PlanInputs::of(user, engine.getCatalogVersion(), engine.getHistoryVersion(user.getId()), mode);
+    PlanResult plan;
+    if (planCache.find(user.getId(), day, inputs, plan) && (reuseTruncated || !plan.truncated)) {
+        return plan;
+    }
+    
+    // 同时生成的请求越多，每个请求分到的预算越少，高峰时宁可返回较差的结果也不超时
+    ScopedCount active(activePlans);
+    double budget = budgetMs > 0 ? std::min(budgetMs, kMaxPlanBudgetMs) : engine.getPlannerTimeBudget();
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double, std::milli>(budget / active.get()));
+    plan = engine.planDailyMeals(user, date, mode, deadline);
+    planCache.store(user.getId(), day, inputs, plan);
+    return plan;
+}
+
 void WebServer::openBrowser(const std::string& url) {
 #ifdef _WIN32
     ShellExecuteA(NULL, "open", url.c_str(), NULL, NULL, SW_SHOWNORMAL);
@@ -259,16 +408,16 @@ void WebServer::start() {
         std::string username = parseJsonString(req.body, "username");
         std::string password = parseJsonString(req.body, "password");
         
-        auto users = db.getAllUsers();
-        for (const auto& user : users) {
-            if (user.getUsername() == username && user.getPassword() == password) {
-                std::string token = generateSessionToken();
-                sessions[token] = user;
-                
-                std::string data = "{\"token\":\"" + token + "\",\"user\":" + userToJson(user) + "}";
-                res.set_content(createJsonResponse(true, u8"登录成功", data), "application/json; charset=utf-8");
-                return;
-            }
+        auto user = db.getUserByUsername(username);
+        if (user && user->getPassword() == password) {
+            std::string token = generateSessionToken();
+            sessions[token] = *user;
+            // 新会话从数据库重新读取资料，不沿用之前编译的打分资料
+            engine.invalidateProfile(user->getId());
+            
+            std::string data = "{\"token\":\"" + token + "\",\"user\":" + userToJson(*user) + "}";
+            res.set_content(createJsonResponse(true, u8"登录成功", data), "application/json; charset=utf-8");
+            return;
         }
         
         res.set_content(createJsonResponse(false, u8"用户名或密码错误"), "application/json; charset=utf-8");
@@ -283,12 +432,9 @@ void WebServer::start() {
         std::string gender = parseJsonString(req.body, "gender");
         std::string activityLevel = parseJsonString(req.body, "activityLevel");
         
-        auto users = db.getAllUsers();
-        for (const auto& user : users) {
-            if (user.getUsername() == username) {
-                res.set_content(createJsonResponse(false, u8"用户名已存在"), "application/json; charset=utf-8");
-                return;
-            }
+        if (db.getUserByUsername(username)) {
+            res.set_content(createJsonResponse(false, u8"用户名已存在"), "application/json; charset=utf-8");
+            return;
         }
         
         int newId = db.getNextUserId();
@@ -351,13 +497,72 @@ void WebServer::start() {
         
         user.calculateNutritionGoals();
         db.updateUser(user);
+        planCache.invalidateUser(user.getId());
+        engine.invalidateProfile(user.getId());
         
         res.set_content(createJsonResponse(true, u8"更新成功", userToJson(user)), "application/json; charset=utf-8");
     });
     
+    svr.Get("/api/cache/stats", [this](const httplib::Request&, httplib::Response& res) {
+        RecommendationCache::Stats stats = planCache.getStats();
+        std::stringstream ss;
+        ss << "{\"hits\":" << stats.hits
+           << ",\"misses\":" << stats.misses
+           << ",\"evictions\":" << stats.evictions
+           << ",\"invalidations\":" << stats.invalidations
+           << ",\"size\":" << stats.size
+           << ",\"capacity\":" << stats.capacity << "}";
+        res.set_content(createJsonResponse(true, "OK", ss.str()), "application/json; charset=utf-8");
+    });
+    
     svr.Get("/api/foods", [this](const httplib::Request& req, httplib::Response& res) {
-        auto foods = db.getAllFoods();
-        res.set_content(createJsonResponse(true, "OK", foodsArrayToJson(foods)), "application/json; charset=utf-8");
+        // 目录不可变，持有引用即可在锁外读取
+        auto catalog = db.getFoodCatalog();
+        res.set_content(createJsonResponse(true, "OK", foodsArrayToJson(catalog->getFoods())), "application/json; charset=utf-8");
+    });
+    
+    svr.Get("/api/foods/alternatives", [this](const httplib::Request& req, httplib::Response& res) {
+        std::string token = req.get_header_value("Authorization");
+        if (token.find("Bearer ") == 0) {
+            token = token.substr(7);
+        }
+        
+        if (sessions.find(token) == sessions.end()) {
+            res.set_content(createJsonResponse(false, u8"未登录或会话已过期"), "application/json; charset=utf-8");
+            return;
+        }
+        
+        User& user = sessions[token];
+        
+        // 必填 foodId；可选 count（默认 3）和 sameCategory=1（只在同类别中挑选）
+        int foodId = 0;
+        int count = 3;
+        try {
+            foodId = TextParser::toInt(req.get_param_value("foodId"));
+        } catch (const std::exception&) {
+            foodId = 0;
+        }
+        if (req.has_param("count")) {
+            try {
+                count = TextParser::toInt(req.get_param_value("count"));
+            } catch (const std::exception&) {
+                count = 0;
+            }
+        }
+        if (count <= 0) {
+            res.set_content(createJsonResponse(false, u8"count 参数无效"), "application/json; charset=utf-8");
+            return;
+        }
+        auto food = db.getFoodById(foodId);
+        if (!food) {
+            res.set_content(createJsonResponse(false, u8"食物不存在"), "application/json; charset=utf-8");
+            return;
+        }
+        bool sameCategory = req.get_param_value("sameCategory") == "1";
+        
+        std::vector<Food> alternatives = engine.getAlternativeFoods(*food, user, std::min(count, kMaxAlternatives),
+                                                                    sameCategory);
+        res.set_content(createJsonResponse(true, "OK", foodsArrayToJson(alternatives)), "application/json; charset=utf-8");
     });
     
     svr.Get("/api/meals/history", [this](const httplib::Request& req, httplib::Response& res) {
@@ -372,8 +577,53 @@ void WebServer::start() {
         }
         
         User& user = sessions[token];
-        auto meals = db.getMealsByUser(user.getId());
-        res.set_content(createJsonResponse(true, "OK", mealsArrayToJson(meals)), "application/json; charset=utf-8");
+        
+        // 可选参数：from / to 限定日期区间（含两端），limit 限定条数，
+        // cursor 取上一页响应中的 nextCursor；结果按日期从新到旧排列
+        Date from = Date::earliest();
+        Date to = Date::latest();
+        auto readDate = [&req](const char* key, Date& value) {
+            if (!req.has_param(key)) return true;
+            auto date = Date::parse(req.get_param_value(key));
+            if (!date) return false;
+            value = *date;
+            return true;
+        };
+        if (!readDate("from", from) || !readDate("to", to)) {
+            res.set_content(createJsonResponse(false, u8"日期格式无效，应为 YYYY-MM-DD"), "application/json; charset=utf-8");
+            return;
+        }
+        
+        size_t limit = 0;
+        if (req.has_param("limit")) {
+            int value = 0;
+            try {
+                value = TextParser::toInt(req.get_param_value("limit"));
+            } catch (const std::exception&) {
+                value = 0;
+            }
+            if (value <= 0) {
+                res.set_content(createJsonResponse(false, u8"limit 参数无效"), "application/json; charset=utf-8");
+                return;
+            }
+            limit = static_cast<size_t>(std::min(value, kMaxHistoryPageSize));
+        }
+        
+        std::optional<MealCursor> cursor;
+        if (req.has_param("cursor")) {
+            cursor = parseMealCursor(req.get_param_value("cursor"));
+            if (!cursor) {
+                res.set_content(createJsonResponse(false, u8"分页游标无效"), "application/json; charset=utf-8");
+                return;
+            }
+        }
+        
+        MealPage page = db.getMealPageByUser(user.getId(), from, to, limit, cursor);
+        std::string extra;
+        if (page.hasMore) {
+            extra = "\"nextCursor\":\"" + formatMealCursor(page.next) + "\"";
+        }
+        res.set_content(createJsonResponse(true, "OK", mealsArrayToJson(page.meals), extra), "application/json; charset=utf-8");
     });
     
     svr.Post("/api/meals/recommend", [this](const httplib::Request& req, httplib::Response& res) {
@@ -389,9 +639,86 @@ void WebServer::start() {
         
         User& user = sessions[token];
         std::string date = parseJsonString(req.body, "date");
+        auto day = Date::parse(date);
+        if (!day) {
+            res.set_content(createJsonResponse(false, u8"日期格式无效，应为 YYYY-MM-DD"), "application/json; charset=utf-8");
+            return;
+        }
+        
+        PlanMode mode;
+        if (!parsePlanMode(parseJsonString(req.body, "mode"), mode)) {
+            res.set_content(createJsonResponse(false, u8"mode 参数无效"), "application/json; charset=utf-8");
+            return;
+        }
         
-        auto recommendation = engine.recommendDailyMeals(user, date);
-        res.set_content(createJsonResponse(true, u8"推荐生成成功", mealsArrayToJson(recommendation)), "application/json; charset=utf-8");
+        // 可选的 budgetMs 为本次推荐的时间预算，用完时返回已找到的最好方案
+        int budgetMs = parseJsonInt(req.body, "budgetMs");
+        if (budgetMs < 0) {
+            res.set_content(createJsonResponse(false, u8"budgetMs 参数无效"), "application/json; charset=utf-8");
+            return;
+        }
+        
+        PlanResult recommendation = dailyPlan(user, *day, date, mode, budgetMs, false);
+        std::stringstream extra;
+        extra << std::fixed << std::setprecision(3) << "\"quality\":" << recommendation.quality
+              << ",\"truncated\":" << (recommendation.truncated ? "true" : "false");
+        res.set_content(createJsonResponse(true, u8"推荐生成成功", mealsArrayToJson(recommendation.meals), extra.str()), "application/json; charset=utf-8");
+    });
+    
+    svr.Post("/api/meals/plan-batch", [this](const httplib::Request& req, httplib::Response& res) {
+        std::string token = req.get_header_value("Authorization");
+        if (token.find("Bearer ") == 0) {
+            token = token.substr(7);
+        }
+        
+        if (sessions.find(token) == sessions.end()) {
+            res.set_content(createJsonResponse(false, u8"未登录或会话已过期"), "application/json; charset=utf-8");
+            return;
+        }
+        
+        User& user = sessions[token];
+        auto from = Date::parse(parseJsonString(req.body, "from"));
+        if (!from) {
+            res.set_content(createJsonResponse(false, u8"日期格式无效，应为 YYYY-MM-DD"), "application/json; charset=utf-8");
+            return;
+        }
+        int days = parseJsonInt(req.body, "days");
+        if (days < 1 || days > kMaxPlanDays) {
+            res.set_content(createJsonResponse(false, u8"days 参数无效，应为 1 到 " + std::to_string(kMaxPlanDays)), "application/json; charset=utf-8");
+            return;
+        }
+        
+        // 只能为当前会话的用户排：对端地址不能用来鉴权，反向代理后面所有请求都来自本机。
+        // userIds 可省略，给出时只能是当前用户的ID
+        std::vector<int> userIds;
+        if (!parseJsonIntArray(req.body, "userIds", userIds)) {
+            res.set_content(createJsonResponse(false, u8"userIds 参数无效"), "application/json; charset=utf-8");
+            return;
+        }
+        for (int userId : userIds) {
+            if (userId != user.getId()) {
+                res.set_content(createJsonResponse(false, u8"无权为其他用户生成推荐"), "application/json; charset=utf-8");
+                return;
+            }
+        }
+        std::vector<User> users = {user};
+        
+        // 只生成不保存，也不写入推荐缓存：后面几天的结果依赖前几天尚未保存的推荐
+        auto plans = engine.recommendBatch(users, *from, days, planPool);
+        std::stringstream ss;
+        ss << "[";
+        for (size_t u = 0; u < users.size(); ++u) {
+            if (u > 0) ss << ",";
+            ss << "{\"userId\":" << users[u].getId() << ",\"days\":[";
+            for (size_t d = 0; d < plans[u].size(); ++d) {
+                if (d > 0) ss << ",";
+                ss << "{\"date\":\"" << from->addDays(static_cast<int32_t>(d)).toString() << "\","
+                   << "\"meals\":" << mealsArrayToJson(plans[u][d]) << "}";
+            }
+            ss << "]}";
+        }
+        ss << "]";
+        res.set_content(createJsonResponse(true, u8"推荐生成成功", ss.str()), "application/json; charset=utf-8");
     });
     
     svr.Get("/api/meals/check-date", [this](const httplib::Request& req, httplib::Response& res) {
@@ -412,9 +739,15 @@ void WebServer::start() {
             res.set_content(createJsonResponse(false, u8"缺少日期参数"), "application/json; charset=utf-8");
             return;
         }
+        auto day = Date::parse(date);
+        if (!day) {
+            res.set_content(createJsonResponse(false, u8"日期格式无效，应为 YYYY-MM-DD"), "application/json; charset=utf-8");
+            return;
+        }
         
-        auto existingMeals = db.getMealsByDateAndUser(date, user.getId());
-        std::string data = std::string("{\"hasExisting\": ") + (existingMeals.empty() ? "false" : "true") + "}";
+        bool hasExisting = false;
+        db.forEachMealOfUserInRange(user.getId(), *day, *day, [&hasExisting](const Meal&) { hasExisting = true; });
+        std::string data = std::string("{\"hasExisting\": ") + (hasExisting ? "true" : "false") + "}";
         res.set_content(createJsonResponse(true, "OK", data), "application/json; charset=utf-8");
     });
     
@@ -435,25 +768,46 @@ void WebServer::start() {
             res.set_content(createJsonResponse(false, u8"缺少日期参数"), "application/json; charset=utf-8");
             return;
         }
+        auto day = Date::parse(date);
+        if (!day) {
+            res.set_content(createJsonResponse(false, u8"日期格式无效，应为 YYYY-MM-DD"), "application/json; charset=utf-8");
+            return;
+        }
 
         bool replaceExisting = parseJsonInt(req.body, "replaceExisting") == 1;
+        PlanMode mode;
+        if (!parsePlanMode(parseJsonString(req.body, "mode"), mode)) {
+            res.set_content(createJsonResponse(false, u8"mode 参数无效"), "application/json; charset=utf-8");
+            return;
+        }
         
+        // 删除旧餐单与写入新餐单作为一个批次原子提交
+        MealBatch batch;
         if (replaceExisting) {
-            int deletedCount = db.deleteMealsByDateAndUser(date, user.getId());
-            if (deletedCount < 0) {
-                res.set_content(createJsonResponse(false, u8"删除旧餐单失败"), "application/json; charset=utf-8");
-                return;
-            }
+            batch.removeDay(*day, user.getId());
         }
         
-        auto recommendation = engine.recommendDailyMeals(user, date);
-        for (auto& meal : recommendation) {
-            meal.setId(db.getNextMealId());
+        // 保存用户刚刚预览的那份推荐
+        PlanResult recommendation = dailyPlan(user, *day, date, mode, 0, true);
+        for (auto& meal : recommendation.meals) {
+            meal.setId(0);
             meal.setUserId(user.getId());
-            db.saveMeal(meal);
+            batch.insert(meal);
+        }
+        
+        MealBatchResult result = db.commitMealBatch(batch);
+        if (!result.success) {
+            res.set_content(createJsonResponse(false, u8"餐单保存失败"), "application/json; charset=utf-8");
+            return;
         }
 
-        reloadEngineHistory();
+        if (replaceExisting) {
+            engine.replaceHistoryDay(user.getId(), *day, result.inserted);
+        } else {
+            for (const auto& meal : result.inserted) {
+                engine.addToHistory(user.getId(), meal);
+            }
+        }
         
         std::string message = replaceExisting ? u8"餐单替换保存成功" : u8"餐单保存成功";
         res.set_content(createJsonResponse(true, message), "application/json; charset=utf-8");
@@ -476,14 +830,19 @@ void WebServer::start() {
             res.set_content(createJsonResponse(false, u8"缺少日期参数"), "application/json; charset=utf-8");
             return;
         }
+        auto day = Date::parse(date);
+        if (!day) {
+            res.set_content(createJsonResponse(false, u8"日期格式无效，应为 YYYY-MM-DD"), "application/json; charset=utf-8");
+            return;
+        }
 
-        int deletedCount = db.deleteMealsByDateAndUser(date, user.getId());
+        int deletedCount = db.deleteMealsByDateAndUser(*day, user.getId());
         if (deletedCount < 0) {
             res.set_content(createJsonResponse(false, u8"删除失败"), "application/json; charset=utf-8");
             return;
         }
 
-        reloadEngineHistory();
+        engine.replaceHistoryDay(user.getId(), *day, {});
 
         std::string data = std::string("{\"deletedCount\":") + std::to_string(deletedCount) + "}";
         std::string message2 = deletedCount == 0 ? u8"当天没有可删除的餐单" : u8"当天餐单删除成功";
@@ -520,7 +879,7 @@ void WebServer::start() {
             return;
         }
 
-        reloadEngineHistory();
+        engine.removeFromHistory(user.getId(), mealId);
 
         res.set_content(createJsonResponse(true, u8"删除成功"), "application/json; charset=utf-8");
     });
@@ -538,5 +897,21 @@ void WebServer::start() {
         openBrowser("http://localhost:" + std::to_string(port));
     }).detach();
     
+    std::atomic<bool> listening(true);
+    std::thread stopWatcher([&svr, &listening]() {
+        while (listening && !stopRequested) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        // 信号可能在 listen 开始前到达，此时 stop() 不起作用，重复调用直到 listen 返回
+        while (listening) {
+            svr.stop();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    });
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
     svr.listen("0.0.0.0", port);
+    listening = false;
+    stopWatcher.join();
+    std::cout << u8"服务器已停止，正在保存数据..." << std::endl;
 }
@@ -1,8 +1,28 @@
 #include "../include/WebServer.h"
 #include <iostream>
+#include <string_view>
 
-int main() {
-    WebServer server(8000, "www");
-    server.start();
+int main(int argc, char* argv[]) {
+    // --persist=sync（默认）| interval:毫秒 | mutations:变更数
+    PersistPolicy persistPolicy = PersistPolicy::sync();
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        std::string_view prefix = "--persist=";
+        if (arg.substr(0, prefix.size()) != prefix ||
+            !PersistPolicy::parse(arg.substr(prefix.size()), persistPolicy)) {
+            std::cerr << u8"参数无效: " << arg << std::endl;
+            std::cerr << u8"用法: " << argv[0] << u8" [--persist=sync|interval:毫秒|mutations:变更数]" << std::endl;
+            return 2;
+        }
+    }
+
+    try {
+        WebServer server(8000, "www", persistPolicy);
+        server.start();
+    } catch (const std::exception& e) {
+        // 例如数据文件中的标签超出标签字典容量：拒绝启动，而不是丢掉数据后继续运行
+        std::cerr << u8"启动失败: " << e.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
@@ -283,10 +283,21 @@ function setupFoodFilters(foods) {
     categoryFilter.addEventListener('change', filterFoods);
 }
 
-async function loadHistory() {
-    const result = await apiCall('/api/meals/history');
+// 历史餐单按页加载，从新到旧；nextCursor 为空表示已加载全部
+const HISTORY_PAGE_SIZE = 60;
+let historyMeals = [];
+let historyCursor = null;
+
+async function loadHistory(append = false) {
+    let endpoint = `/api/meals/history?limit=${HISTORY_PAGE_SIZE}`;
+    if (append && historyCursor) {
+        endpoint += `&cursor=${encodeURIComponent(historyCursor)}`;
+    }
+    const result = await apiCall(endpoint);
     if (result && result.data) {
-        displayHistory(result.data);
+        historyMeals = append ? historyMeals.concat(result.data) : result.data;
+        historyCursor = result.nextCursor || null;
+        displayHistory(historyMeals);
     }
 }
 
@@ -349,7 +360,11 @@ function displayHistory(meals) {
                     </div>
                 </div>
             `;
-        }).join('');
+        }).join('') + (historyCursor ? `
+            <div style="text-align: center; margin-top: 10px;">
+                <button class="btn-primary" onclick="loadHistory(true)">加载更早的记录</button>
+            </div>
+        ` : '');
 }
 
 function createMealCard(meal, showDelete = false) {
@@ -399,7 +414,7 @@ function createMealCard(meal, showDelete = false) {
             <div class="meal-foods">
                 <div class="meal-foods-title">包含食物：</div>
                 <div class="food-tags">
-                    ${meal.foods.map(food => `<span class="food-tag">${food.name}</span>`).join('')}
+                    ${meal.foods.map(food => `<span class="food-tag">${food.name}${food.portion && food.portion !== 1 ? ' ×' + food.portion : ''}</span>`).join('')}
                 </div>
             </div>
         </div>
@@ -413,6 +428,7 @@ function setupRecommend() {
 
 document.getElementById('generateBtn').addEventListener('click', async () => {
     const date = document.getElementById('recommendDate').value;
+    const mode = document.getElementById('recommendMode').value;
     if (!date) {
         showToast('请选择日期', 'error');
         return;
@@ -420,11 +436,11 @@ document.getElementById('generateBtn').addEventListener('click', async () => {
     
     const result = await apiCall('/api/meals/recommend', {
         method: 'POST',
-        body: JSON.stringify({ date })
+        body: JSON.stringify({ date, mode })
     });
     
     if (result && result.data) {
-        displayRecommendation(result.data, date);
+        displayRecommendation(result.data, date, mode, result);
     }
 });
 
@@ -432,6 +448,7 @@ const checkDateBtn = document.getElementById('checkDateBtn');
 if (checkDateBtn) {
     checkDateBtn.addEventListener('click', async () => {
         const date = document.getElementById('recommendDate').value;
+        const mode = document.getElementById('recommendMode').value;
         if (!date) {
             showToast('请选择日期', 'error');
             return;
@@ -441,19 +458,19 @@ if (checkDateBtn) {
         if (result && result.data) {
             if (result.data.hasExisting) {
                 showConfirmDialog('此日期已有保存的餐单，是否替换为新的推荐？', async () => {
-                    await saveRecommendation(date, true);
+                    await saveRecommendation(date, true, mode);
                 });
             } else {
-                await saveRecommendation(date, false);
+                await saveRecommendation(date, false, mode);
             }
         }
     });
 }
 
-async function saveRecommendation(date, replaceExisting) {
+async function saveRecommendation(date, replaceExisting, mode) {
     const result = await apiCall('/api/meals/save', {
         method: 'POST',
-        body: JSON.stringify({ date, replaceExisting: replaceExisting ? 1 : 0 })
+        body: JSON.stringify({ date, replaceExisting: replaceExisting ? 1 : 0, mode })
     });
     
     if (result) {
@@ -516,7 +533,7 @@ function showConfirmDialog(message, onConfirm, onCancel = null) {
     };
 }
 
-function displayRecommendation(meals, date) {
+function displayRecommendation(meals, date, mode, plan = {}) {
     const grid = document.getElementById('recommendResults');
     
     const totalCalories = meals.reduce((sum, m) => sum + m.totalCalories, 0);
@@ -527,7 +544,8 @@ function displayRecommendation(meals, date) {
     grid.innerHTML = `
         <div style="background: linear-gradient(135deg, #43e97b 0%, #38f9d7 100%); padding: 30px; border-radius: 20px; color: white; margin-bottom: 25px; text-align: center;">
             <h3 style="font-size: 24px; margin-bottom: 10px;">✨ 为您精心推荐</h3>
-            <p style="opacity: 0.9; margin-bottom: 20px;">${date} 的营养配餐方案</p>
+            <p style="opacity: 0.9; margin-bottom: ${plan.quality !== undefined ? 5 : 20}px;">${date} 的营养配餐方案</p>
+            ${plan.quality !== undefined ? `<p style="opacity: 0.9; font-size: 13px; margin-bottom: 20px;">营养达成度 ${Math.round(plan.quality * 100)}%${plan.truncated ? '（限时内找到的最佳方案）' : ''}</p>` : ''}
             <div style="display: flex; gap: 15px; justify-content: center; flex-wrap: wrap;">
                 <button id="saveRecommendationBtn" class="btn-primary" style="background: white; color: #43e97b; max-width: 180px; margin: 0 auto;">
                     💾 保存餐单
@@ -571,10 +589,10 @@ function displayRecommendation(meals, date) {
         if (result && result.data) {
             if (result.data.hasExisting) {
                 showConfirmDialog('此日期已有保存的餐单，是否替换为新的推荐？', async () => {
-                    await saveRecommendation(date, true);
+                    await saveRecommendation(date, true, mode);
                 });
             } else {
-                await saveRecommendation(date, false);
+                await saveRecommendation(date, false, mode);
             }
         }
     });